@@ -0,0 +1,630 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Multi-instance stress harness: drives N processors from M worker threads
+    the way a host's parallel graph does, and reports how many instances a
+    machine can carry.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/RealtimeAudit.h"
+
+#if JUCE_LINUX
+ #include <unistd.h>
+#elif JUCE_MAC
+ #include <mach/mach.h>
+#endif
+
+#include <iostream>
+
+struct Options {
+    int numInstances = 100;
+    int numThreads = juce::SystemStats::getNumCpus();
+    int blockSize = 512;
+    double sampleRate = 48000.0;
+    double seconds = 10.0;
+    bool decimated = false;
+    juce::File dataDirectory = juce::File::getCurrentWorkingDirectory().getChildFile( "Data" );
+};
+
+static Options parseOptions( const juce::ArgumentList& args ) {
+    Options options;
+
+    if ( args.containsOption( "--instances" ) )
+        options.numInstances = juce::jlimit( 1, 1000, args.getValueForOption( "--instances" ).getIntValue() );
+    if ( args.containsOption( "--threads" ) )
+        options.numThreads = juce::jmax( 1, args.getValueForOption( "--threads" ).getIntValue() );
+    if ( args.containsOption( "--block" ) )
+        options.blockSize = juce::jmax( 16, args.getValueForOption( "--block" ).getIntValue() );
+    if ( args.containsOption( "--rate" ) )
+        options.sampleRate = juce::jmax( 8000.0, args.getValueForOption( "--rate" ).getDoubleValue() );
+    if ( args.containsOption( "--seconds" ) )
+        options.seconds = juce::jmax( 0.1, args.getValueForOption( "--seconds" ).getDoubleValue() );
+    if ( args.containsOption( "--data" ) )
+        options.dataDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(
+            args.getValueForOption( "--data" ) );
+
+    options.decimated = args.containsOption( "--decimated" );
+    return options;
+}
+
+static juce::int64 getResidentBytes() {
+   #if JUCE_LINUX
+    juce::StringArray fields;
+    fields.addTokens( juce::File( "/proc/self/statm" ).loadFileAsString(), " ", {} );
+    return fields[ 1 ].getLargeIntValue() * sysconf( _SC_PAGESIZE );
+   #elif JUCE_MAC
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if ( task_info( mach_task_self(), MACH_TASK_BASIC_INFO,
+                    reinterpret_cast< task_info_t >( &info ), &count ) == KERN_SUCCESS )
+        return static_cast< juce::int64 >( info.resident_size );
+    return 0;
+   #else
+    return 0;
+   #endif
+}
+
+static std::vector< juce::AudioBuffer< float > > loadPrograms( const juce::File& directory,
+                                                               double sampleRate ) {
+/* load every .wav file in the directory as stereo, resampled to the session rate */
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    std::vector< juce::AudioBuffer< float > > programs;
+
+    for ( const auto& file : directory.findChildFiles( juce::File::findFiles, false, "*.wav" ) ) {
+        std::unique_ptr< juce::AudioFormatReader > reader( formats.createReaderFor( file ) );
+        if ( reader == nullptr || reader->lengthInSamples == 0 )
+            continue;
+
+        const int length = static_cast< int >( reader->lengthInSamples );
+        juce::AudioBuffer< float > source( 2, length );
+        reader->read( &source, 0, length, 0, true, true );
+
+        // leave a few samples for the interpolator to read ahead
+        const double ratio = reader->sampleRate / sampleRate;
+        const int resampledLength = static_cast< int >( length / ratio ) - 8;
+
+        juce::AudioBuffer< float > program( 2, resampledLength );
+        for ( int ch = 0; ch < 2; ch++ ) {
+            juce::LagrangeInterpolator interpolator;
+            interpolator.process( ratio, source.getReadPointer( ch ),
+                                  program.getWritePointer( ch ), resampledLength );
+        }
+
+        std::cout << "Loaded " << file.getFileName() << " ("
+                  << juce::String( resampledLength / sampleRate, 1 ) << " s)" << std::endl;
+        programs.push_back( std::move( program ) );
+    }
+
+    return programs;
+}
+
+static void setParameter( juce::AudioProcessor& processor, const juce::String& id, bool value ) {
+    for ( auto* parameter : processor.getParameters() )
+        if ( auto* withId = dynamic_cast< juce::AudioProcessorParameterWithID* >( parameter ) )
+            if ( withId->paramID == id )
+                withId->setValueNotifyingHost( value ? 1.f : 0.f );
+}
+
+static std::unique_ptr< SimpleCorrelationMeterAudioProcessor > createProcessor(
+    const Options& options, bool decimated ) {
+    auto processor = std::make_unique< SimpleCorrelationMeterAudioProcessor >();
+    processor->setRateAndBufferSizeDetails( options.sampleRate, options.blockSize );
+    processor->prepareToPlay( options.sampleRate, options.blockSize );
+    setParameter( *processor, "Decimated Analysis", decimated );
+    return processor;
+}
+
+static void copyBlock( const juce::AudioBuffer< float >& program, int& position,
+                       juce::AudioBuffer< float >& block ) {
+/* copy the next block of the program into block, looping at the end */
+    const int numSamples = block.getNumSamples();
+
+    for ( int done = 0; done < numSamples; ) {
+        if ( position >= program.getNumSamples() )
+            position = 0;
+
+        const int count = juce::jmin( numSamples - done, program.getNumSamples() - position );
+        for ( int ch = 0; ch < 2; ch++ )
+            block.copyFrom( ch, done, program, ch, position, count );
+
+        done += count;
+        position += count;
+    }
+}
+
+//==============================================================================
+/* host transport that keeps playing, so the playhead handling runs in every callback */
+struct PlayingTransport : juce::AudioPlayHead {
+    juce::Optional< PositionInfo > getPosition() const override {
+        PositionInfo info;
+        info.setIsPlaying( true );
+        info.setTimeInSamples( position );
+        return info;
+    }
+
+    juce::int64 position = 0;
+};
+
+struct Instance {
+    std::unique_ptr< SimpleCorrelationMeterAudioProcessor > processor;
+    juce::AudioBuffer< float > block;
+    juce::MidiBuffer midi;
+    PlayingTransport transport;
+
+    const juce::AudioBuffer< float >* program = nullptr;
+    int position = 0;
+
+    juce::int64 worstTicks = 0;
+};
+
+/*
+Processes all instances once per host callback, spread over a fixed set of
+threads that pull the next unprocessed instance, like a host's parallel graph.
+*/
+class ParallelGraph {
+public:
+    ParallelGraph( std::vector< Instance >& instances, int numThreads ) : instances( instances ) {
+        for ( int i = 0; i < numThreads; i++ ) {
+            auto* worker = workers.add( new Worker( *this, i ) );
+            worker->startThread( juce::Thread::Priority::highest );
+        }
+    }
+
+    ~ParallelGraph() {
+        for ( auto* worker : workers ) {
+            worker->signalThreadShouldExit();
+            worker->start.signal();
+        }
+
+        for ( auto* worker : workers )
+            worker->stopThread( 1000 );
+    }
+
+    void runCycle() {
+    /* blocks until every instance has processed one block */
+        nextInstance = 0;
+        remainingWorkers = workers.size();
+
+        for ( auto* worker : workers )
+            worker->start.signal();
+
+        cycleDone.wait();
+    }
+
+private:
+    class Worker : public juce::Thread {
+    public:
+        Worker( ParallelGraph& owner, int index ) :
+                juce::Thread( "Graph worker " + juce::String( index ) ),
+                owner( owner ) {}
+
+        void run() override {
+            while ( true ) {
+                start.wait();
+                if ( threadShouldExit() )
+                    break;
+
+                owner.processPending();
+
+                if ( --owner.remainingWorkers == 0 )
+                    owner.cycleDone.signal();
+            }
+        }
+
+        juce::WaitableEvent start;
+
+    private:
+        ParallelGraph& owner;
+    };
+
+    void processPending() {
+        for ( int i = nextInstance++; i < static_cast< int >( instances.size() ); i = nextInstance++ ) {
+            auto& instance = instances[ static_cast< size_t >( i ) ];
+            copyBlock( *instance.program, instance.position, instance.block );
+
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            {
+                const RealtimeAudit::ScopedCallback callback;
+                instance.processor->processBlock( instance.block, instance.midi );
+            }
+            instance.transport.position += instance.block.getNumSamples();
+            instance.worstTicks = juce::jmax( instance.worstTicks,
+                                              juce::Time::getHighResolutionTicks() - startTicks );
+        }
+    }
+
+    std::vector< Instance >& instances;
+    juce::OwnedArray< Worker > workers;
+
+    std::atomic< int > nextInstance{ 0 };
+    std::atomic< int > remainingWorkers{ 0 };
+    juce::WaitableEvent cycleDone;
+};
+
+//==============================================================================
+static bool checkDecimatedAnalysis( const std::vector< juce::AudioBuffer< float > >& programs,
+                                    const Options& options ) {
+/*
+compare the decimated analysis path against full-rate analysis on the same
+audio; fails if it is no cheaper than the full-rate path it replaces
+*/
+    std::cout << std::endl << "Decimated analysis accuracy" << std::endl;
+
+    const int factor = Dsp::AnalysisDecimator::chooseFactor( options.sampleRate );
+    if ( factor == 1 ) {
+        std::cout << "  inactive at " << options.sampleRate
+                  << " Hz, run with --rate 192000 to measure" << std::endl;
+        return true;
+    }
+
+    bool passed = true;
+
+    for ( size_t p = 0; p < programs.size(); p++ ) {
+        auto full = createProcessor( options, false );
+        auto decimated = createProcessor( options, true );
+
+        juce::AudioBuffer< float > fullBlock( 2, options.blockSize ), decimatedBlock( 2, options.blockSize );
+        juce::MidiBuffer midi;
+
+        double maxCorrelationError = 0.0, sumCorrelationError = 0.0, maxRmsError = 0.0;
+        juce::int64 fullTicks = 0, decimatedTicks = 0;
+        int numBlocks = 0;
+
+        int fullPosition = 0, decimatedPosition = 0;
+        while ( fullPosition + options.blockSize <= programs[ p ].getNumSamples() ) {
+            copyBlock( programs[ p ], fullPosition, fullBlock );
+            copyBlock( programs[ p ], decimatedPosition, decimatedBlock );
+
+            auto startTicks = juce::Time::getHighResolutionTicks();
+            full->processBlock( fullBlock, midi );
+            fullTicks += juce::Time::getHighResolutionTicks() - startTicks;
+
+            startTicks = juce::Time::getHighResolutionTicks();
+            decimated->processBlock( decimatedBlock, midi );
+            decimatedTicks += juce::Time::getHighResolutionTicks() - startTicks;
+
+            const double correlationError =
+                std::abs( full->getCorrelationIn() - decimated->getCorrelationIn() );
+            maxCorrelationError = juce::jmax( maxCorrelationError, correlationError );
+            sumCorrelationError += correlationError;
+
+            // level differences below the meter's range don't matter
+            for ( int ch = 0; ch < 2; ch++ )
+                if ( full->getRmsValue( ch ) > -60.f )
+                    maxRmsError = juce::jmax( maxRmsError, static_cast< double >(
+                        std::abs( full->getRmsValue( ch ) - decimated->getRmsValue( ch ) ) ) );
+
+            numBlocks++;
+        }
+
+        const double speedup = static_cast< double >( fullTicks ) /
+                               juce::jmax( juce::int64( 1 ), decimatedTicks );
+        passed = passed && speedup >= 1.0;
+
+        std::cout << "  program " << p + 1 << ", factor " << factor
+                  << ": correlation error max " << juce::String( maxCorrelationError, 4 )
+                  << ", mean " << juce::String( sumCorrelationError / juce::jmax( 1, numBlocks ), 4 )
+                  << "; RMS error max " << juce::String( maxRmsError, 2 ) << " dB"
+                  << "; speedup " << juce::String( speedup, 2 ) << "x"
+                  << ( speedup >= 1.0 ? "" : " FAILED" ) << std::endl;
+    }
+
+    return passed;
+}
+
+static void reportAliasRejection( const std::vector< juce::AudioBuffer< float > >& programs,
+                                  const Options& options ) {
+/*
+the decimated path on content above the decimated Nyquist frequency, which the
+resampled Data/ files don't have: anything it lets through aliases into the band
+*/
+    std::cout << std::endl << "Decimated analysis with ultrasonic content" << std::endl;
+
+    const int factor = Dsp::AnalysisDecimator::chooseFactor( options.sampleRate );
+    if ( factor == 1 ) {
+        std::cout << "  inactive at " << options.sampleRate
+                  << " Hz, run with --rate 192000 to measure" << std::endl;
+        return;
+    }
+
+    // 30 kHz in opposite polarity on the two channels, 12 dB below full scale;
+    // at a decimated rate of 48 kHz it would alias to 18 kHz
+    const double toneFrequency = 30000.0;
+    const double toneGain = juce::Decibels::decibelsToGain( -12.0 );
+    const auto& program = programs.front();
+    const int length = program.getNumSamples();
+
+    juce::AudioBuffer< float > tone( 2, length ), mixed( 2, length );
+    for ( int i = 0; i < length; i++ ) {
+        const auto sample = static_cast< float >( toneGain * std::sin(
+            juce::MathConstants< double >::twoPi * toneFrequency * i / options.sampleRate ) );
+        tone.setSample( 0, i, sample );
+        tone.setSample( 1, i, -sample );
+        mixed.setSample( 0, i, program.getSample( 0, i ) + sample );
+        mixed.setSample( 1, i, program.getSample( 1, i ) - sample );
+    }
+
+    juce::AudioBuffer< float > referenceBlock( 2, options.blockSize ), testBlock( 2, options.blockSize );
+    juce::MidiBuffer midi;
+
+    // alone, the tone lies entirely in the stopband and should all but vanish
+    {
+        auto full = createProcessor( options, false );
+        auto decimated = createProcessor( options, true );
+
+        int fullPosition = 0, decimatedPosition = 0;
+        while ( fullPosition + options.blockSize <= length ) {
+            copyBlock( tone, fullPosition, referenceBlock );
+            copyBlock( tone, decimatedPosition, testBlock );
+            full->processBlock( referenceBlock, midi );
+            decimated->processBlock( testBlock, midi );
+        }
+
+        std::cout << "  30 kHz tone alone: RMS " << juce::String( full->getRmsValue( 0 ), 1 )
+                  << " dB at full rate, " << juce::String( decimated->getRmsValue( 0 ), 1 )
+                  << " dB decimated (factor " << factor << ")" << std::endl;
+    }
+
+    // on top of a programme it must not move the measured correlation; the
+    // reference is the programme alone at full rate
+    {
+        auto reference = createProcessor( options, false );
+        auto decimated = createProcessor( options, true );
+
+        double maxCorrelationError = 0.0, sumCorrelationError = 0.0;
+        int numBlocks = 0;
+
+        int referencePosition = 0, testPosition = 0;
+        while ( referencePosition + options.blockSize <= length ) {
+            copyBlock( program, referencePosition, referenceBlock );
+            copyBlock( mixed, testPosition, testBlock );
+            reference->processBlock( referenceBlock, midi );
+            decimated->processBlock( testBlock, midi );
+
+            const double correlationError =
+                std::abs( reference->getCorrelationIn() - decimated->getCorrelationIn() );
+            maxCorrelationError = juce::jmax( maxCorrelationError, correlationError );
+            sumCorrelationError += correlationError;
+            numBlocks++;
+        }
+
+        std::cout << "  program 1 with the tone, decimated, against program 1 alone at full rate: "
+                  << "correlation error max " << juce::String( maxCorrelationError, 4 )
+                  << ", mean " << juce::String( sumCorrelationError / juce::jmax( 1, numBlocks ), 4 )
+                  << std::endl;
+    }
+}
+
+static void reportPhaseAnalysisCost( const std::vector< juce::AudioBuffer< float > >& programs,
+                                     const Options& options ) {
+/* per-sample cost of the Hilbert phase stage next to the broadband correlation */
+    std::cout << std::endl << "Phase analysis cost" << std::endl;
+
+    for ( size_t p = 0; p < programs.size(); p++ ) {
+        const auto& program = programs[ p ];
+        const int numBlocks = program.getNumSamples() / options.blockSize;
+        if ( numBlocks == 0 )
+            continue;
+
+        Dsp::HilbertAnalyser hilbert;
+        Dsp::HilbertAnalyser::Result result;
+        juce::int64 correlationTicks = 0, hilbertTicks = 0;
+        double sumCorrelation = 0.0, sumCoherence = 0.0;
+
+        for ( int b = 0; b < numBlocks; b++ ) {
+            const float* left = program.getReadPointer( 0, b * options.blockSize );
+            const float* right = program.getReadPointer( 1, b * options.blockSize );
+
+            auto startTicks = juce::Time::getHighResolutionTicks();
+            sumCorrelation += Dsp::CorrelationStatistics< float >::fromSamples( left, right, options.blockSize )
+                        .getCorrelation();
+            correlationTicks += juce::Time::getHighResolutionTicks() - startTicks;
+
+            startTicks = juce::Time::getHighResolutionTicks();
+            hilbert.process( left, right, options.blockSize, result );
+            hilbertTicks += juce::Time::getHighResolutionTicks() - startTicks;
+            sumCoherence += result.coherence;
+        }
+
+        const double numSamples = static_cast< double >( numBlocks ) * options.blockSize;
+        const auto toNanoseconds = [ & ]( juce::int64 ticks ) {
+            return juce::Time::highResolutionTicksToSeconds( ticks ) * 1.0e9 / numSamples;
+        };
+
+        // printing the results also keeps the measured work from being optimised away
+        std::cout << "  program " << p + 1
+                  << ": correlation " << juce::String( toNanoseconds( correlationTicks ), 2 ) << " ns"
+                  << " (mean " << juce::String( sumCorrelation / numBlocks, 3 ) << ")"
+                  << ", Hilbert phase " << juce::String( toNanoseconds( hilbertTicks ), 2 ) << " ns"
+                  << " (mean coherence " << juce::String( sumCoherence / numBlocks, 3 ) << ")"
+                  << " per stereo sample" << std::endl;
+    }
+}
+
+static bool checkPhaseAnalysis( const Options& options ) {
+/* sign of the phase difference, and independence of the block sizes */
+    std::cout << std::endl << "Phase analysis checks" << std::endl;
+    
+    using Analyser = Dsp::HilbertAnalyser;
+    const int numSamples = juce::roundToInt( options.sampleRate );
+    juce::AudioBuffer< float > signal( 2, numSamples );
+    juce::Random random( 2 );
+    
+    // a 1 kHz tone with the right channel 45 degrees ahead
+    const double omega = juce::MathConstants< double >::twoPi * 1000.0 / options.sampleRate;
+    for ( int i = 0; i < numSamples; i++ ) {
+        signal.setSample( 0, i, static_cast< float >( std::sin( omega * i ) ) );
+        signal.setSample( 1, i, static_cast< float >( std::sin( omega * i +
+                                                                juce::MathConstants< double >::pi / 4.0 ) ) );
+    }
+    
+    Analyser analyser;
+    Analyser::Result result;
+    analyser.process( signal.getReadPointer( 0 ), signal.getReadPointer( 1 ), numSamples, result );
+    
+    // bins 9 and 10 span 22.5 to 67.5 degrees
+    const float leadingWeight = result.histogram[ 9 ] + result.histogram[ 10 ];
+    const bool orientationPassed = leadingWeight > 0.9f;
+    std::cout << "  right channel 45 degrees ahead: " << juce::String( leadingWeight, 3 )
+              << " of the weight between 22.5 and 67.5 degrees"
+              << ( orientationPassed ? "" : " FAILED" ) << std::endl;
+    
+    // the same noise in odd-sized blocks and in one block has to leave the
+    // filters in the same state, so the block that follows measures the same
+    for ( int ch = 0; ch < 2; ch++ )
+        for ( int i = 0; i < numSamples; i++ )
+            signal.setSample( ch, i, random.nextFloat() * 2.f - 1.f );
+    
+    const int tailSize = 256;
+    const int headSize = numSamples - tailSize;
+    const int blockSizes[] = { 1, 7, 2, 513, 3, 1000, 5 };
+    
+    Analyser contiguous, chunked;
+    Analyser::Result contiguousResult, chunkedResult;
+    contiguous.process( signal.getReadPointer( 0 ), signal.getReadPointer( 1 ), headSize, contiguousResult );
+    
+    for ( int position = 0, b = 0; position < headSize; b++ ) {
+        const int size = juce::jmin( blockSizes[ b % std::size( blockSizes ) ], headSize - position );
+        chunked.process( signal.getReadPointer( 0, position ), signal.getReadPointer( 1, position ),
+                         size, chunkedResult );
+        position += size;
+    }
+    
+    contiguous.process( signal.getReadPointer( 0, headSize ), signal.getReadPointer( 1, headSize ),
+                        tailSize, contiguousResult );
+    chunked.process( signal.getReadPointer( 0, headSize ), signal.getReadPointer( 1, headSize ),
+                     tailSize, chunkedResult );
+    
+    float maxDifference = std::abs( contiguousResult.coherence - chunkedResult.coherence );
+    for ( int bin = 0; bin < Analyser::numHistogramBins; bin++ )
+        maxDifference = juce::jmax( maxDifference, std::abs( contiguousResult.histogram[ bin ] -
+                                                             chunkedResult.histogram[ bin ] ) );
+    
+    const bool blockSizesPassed = maxDifference < 1.0e-5f;
+    std::cout << "  odd-sized blocks against one block: max difference "
+              << juce::String( maxDifference, 7 ) << ( blockSizesPassed ? "" : " FAILED" ) << std::endl;
+    
+    return orientationPassed && blockSizesPassed;
+}
+
+static void runStressTest( const std::vector< juce::AudioBuffer< float > >& programs,
+                           const Options& options ) {
+    std::cout << std::endl << options.numInstances << " instances on " << options.numThreads
+              << " threads, " << options.blockSize << " samples at " << options.sampleRate
+              << " Hz" << ( options.decimated ? ", decimated analysis" : "" ) << std::endl;
+
+    const auto residentBefore = getResidentBytes();
+
+    juce::Random random( 1 );
+    std::vector< Instance > instances( static_cast< size_t >( options.numInstances ) );
+    for ( size_t i = 0; i < instances.size(); i++ ) {
+        auto& instance = instances[ i ];
+        instance.processor = createProcessor( options, options.decimated );
+        instance.processor->setPlayHead( &instance.transport );
+        instance.block.setSize( 2, options.blockSize );
+        instance.program = &programs[ i % programs.size() ];
+        instance.position = random.nextInt( instance.program->getNumSamples() );
+    }
+
+    const auto residentAfter = getResidentBytes();
+
+    ParallelGraph graph( instances, options.numThreads );
+
+    // let caches and the analysis workers settle before measuring
+    for ( int i = 0; i < 16; i++ )
+        graph.runCycle();
+
+    const int numCycles = juce::jmax( 1, juce::roundToInt( options.seconds * options.sampleRate /
+                                                           options.blockSize ) );
+    const double periodMs = 1000.0 * options.blockSize / options.sampleRate;
+
+    int deadlineMisses = 0;
+    double worstCycleMs = 0.0;
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    for ( int i = 0; i < numCycles; i++ ) {
+        const auto cycleStart = juce::Time::getHighResolutionTicks();
+        graph.runCycle();
+        const double cycleMs = juce::Time::highResolutionTicksToSeconds(
+            juce::Time::getHighResolutionTicks() - cycleStart ) * 1000.0;
+
+        worstCycleMs = juce::jmax( worstCycleMs, cycleMs );
+        if ( cycleMs > periodMs )
+            deadlineMisses++;
+    }
+    const double elapsedSeconds = juce::Time::highResolutionTicksToSeconds(
+        juce::Time::getHighResolutionTicks() - startTicks );
+
+    // give the background analysis a moment to catch up before reading its counters
+    juce::Thread::sleep( 300 );
+
+    juce::int64 worstTicks = 0;
+    double workerMs = 0.0;
+    for ( const auto& instance : instances ) {
+        worstTicks = juce::jmax( worstTicks, instance.worstTicks );
+        workerMs += instance.processor->getAnalysisWorkerTimeMs();
+    }
+
+    const double audioSeconds = numCycles * options.blockSize / options.sampleRate;
+
+    std::cout << "  throughput:        "
+              << juce::String( audioSeconds * options.numInstances / elapsedSeconds, 1 )
+              << "x realtime (instance-seconds per second)" << std::endl;
+    std::cout << "  callback period:   " << juce::String( periodMs, 3 ) << " ms, mean "
+              << juce::String( elapsedSeconds * 1000.0 / numCycles, 3 ) << " ms, worst "
+              << juce::String( worstCycleMs, 3 ) << " ms" << std::endl;
+    std::cout << "  deadline misses:   " << deadlineMisses << " / " << numCycles << " ("
+              << juce::String( 100.0 * deadlineMisses / numCycles, 2 ) << "%)" << std::endl;
+    std::cout << "  worst processBlock: "
+              << juce::String( juce::Time::highResolutionTicksToSeconds( worstTicks ) * 1.0e6, 1 )
+              << " us" << std::endl;
+    if ( RealtimeAudit::enabled )
+        std::cout << "  real-time audit:   " << RealtimeAudit::getNumCallbacks()
+                  << " callbacks without violations, worst "
+                  << juce::String( RealtimeAudit::getWorstCallbackMs() * 1000.0, 1 ) << " us" << std::endl;
+    std::cout << "  memory per instance: "
+              << ( residentAfter - residentBefore ) / options.numInstances << " bytes resident, "
+              << sizeof( SimpleCorrelationMeterAudioProcessor ) << " bytes object" << std::endl;
+    std::cout << "  analysis worker time per instance: "
+              << juce::String( workerMs / options.numInstances, 3 ) << " ms" << std::endl;
+
+    if ( deadlineMisses == 0 )
+        std::cout << "  => this machine carries " << options.numInstances
+                  << " instances at these settings" << std::endl;
+}
+
+//==============================================================================
+int main( int argc, char* argv[] )
+{
+    // the processors' parameter state needs a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const juce::ArgumentList args( argc, argv );
+    const auto options = parseOptions( args );
+
+    const auto programs = loadPrograms( options.dataDirectory, options.sampleRate );
+    if ( programs.empty() ) {
+        std::cerr << "No .wav files found in " << options.dataDirectory.getFullPathName()
+                  << " (use --data <directory>)" << std::endl;
+        return 1;
+    }
+
+    const bool decimationPassed = checkDecimatedAnalysis( programs, options );
+    reportAliasRejection( programs, options );
+    reportPhaseAnalysisCost( programs, options );
+    
+    if ( ! checkPhaseAnalysis( options ) || ! decimationPassed )
+        return 1;
+    
+    runStressTest( programs, options );
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    FileScan.cpp
+
+  ==============================================================================
+*/
+
+#include "FileScan.h"
+
+// fixed, so that the reduction order never depends on the thread count
+const int WINDOWS_PER_CHUNK = 256;
+
+// read size of the single-pass reference
+const int READ_BLOCK_SIZE = 65536;
+
+static ScanResult scanChunk( juce::AudioFormatManager& formats, const juce::File& file,
+                             juce::int64 start, juce::int64 length, int windowSize ) {
+    ScanResult result;
+    
+    // readers aren't thread-safe, so every chunk opens its own
+    std::unique_ptr< juce::AudioFormatReader > reader( formats.createReaderFor( file ) );
+    if ( reader == nullptr )
+        return result;
+    
+    result.opened = true;
+    juce::AudioBuffer< float > window( 2, windowSize );
+    
+    for ( juce::int64 position = 0; position < length; position += windowSize ) {
+        const int numSamples = static_cast< int >( juce::jmin( juce::int64( windowSize ),
+                                                               length - position ) );
+        reader->read( &window, 0, numSamples, start + position, true, true );
+        
+        const auto statistics = Dsp::CorrelationStatistics< double >::fromSamples(
+            window.getReadPointer( 0 ), window.getReadPointer( 1 ), numSamples );
+        
+        result.statistics.merge( statistics );
+        result.summary.add( statistics.getCorrelation() );
+    }
+    
+    return result;
+}
+
+ScanResult scanFile( const juce::File& file, int windowSize, int numThreads ) {
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+    
+    juce::int64 length = 0;
+    {
+        std::unique_ptr< juce::AudioFormatReader > reader( formats.createReaderFor( file ) );
+        if ( reader == nullptr )
+            return {};
+        
+        length = reader->lengthInSamples;
+    }
+    
+    const juce::int64 chunkLength = juce::int64( windowSize ) * WINDOWS_PER_CHUNK;
+    const auto numChunks = static_cast< size_t >( ( length + chunkLength - 1 ) / chunkLength );
+    std::vector< ScanResult > chunks( numChunks );
+    
+    if ( numChunks > 0 ) {
+        juce::ThreadPool pool( numThreads );
+        
+        // the pool's destructor would drop jobs that haven't started yet, so the
+        // last chunk to finish wakes this thread
+        std::atomic< size_t > numRemaining{ numChunks };
+        juce::WaitableEvent finished;
+        
+        for ( size_t c = 0; c < numChunks; c++ ) {
+            pool.addJob( [ &, c ] {
+                const auto start = static_cast< juce::int64 >( c ) * chunkLength;
+                chunks[ c ] = scanChunk( formats, file, start,
+                                         juce::jmin( chunkLength, length - start ), windowSize );
+                
+                if ( --numRemaining == 0 )
+                    finished.signal();
+            } );
+        }
+        
+        finished.wait();
+    }
+    
+    ScanResult result;
+    result.opened = true;
+    
+    for ( const auto& chunk : chunks ) {
+        result.opened = result.opened && chunk.opened;
+        result.statistics.merge( chunk.statistics );
+        result.summary.merge( chunk.summary );
+    }
+    
+    return result;
+}
+
+ScanResult scanFileSinglePass( const juce::File& file ) {
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+    
+    std::unique_ptr< juce::AudioFormatReader > reader( formats.createReaderFor( file ) );
+    if ( reader == nullptr )
+        return {};
+    
+    ScanResult result;
+    result.opened = true;
+    
+    const auto length = reader->lengthInSamples;
+    juce::AudioBuffer< float > block( 2, READ_BLOCK_SIZE );
+    auto& statistics = result.statistics;
+    
+    const auto forEachBlock = [ & ]( auto&& process ) {
+        for ( juce::int64 position = 0; position < length; position += READ_BLOCK_SIZE ) {
+            const int numSamples = static_cast< int >( juce::jmin( juce::int64( READ_BLOCK_SIZE ),
+                                                                   length - position ) );
+            reader->read( &block, 0, numSamples, position, true, true );
+            
+            const float* x = block.getReadPointer( 0 );
+            const float* y = block.getReadPointer( 1 );
+            for ( int i = 0; i < numSamples; i++ )
+                process( x[ i ], y[ i ] );
+        }
+    };
+    
+    forEachBlock( [ & ]( float x, float y ) {
+        statistics.meanX += x;
+        statistics.meanY += y;
+    } );
+    
+    statistics.count = length;
+    if ( length == 0 )
+        return result;
+    
+    statistics.meanX /= static_cast< double >( length );
+    statistics.meanY /= static_cast< double >( length );
+    
+    forEachBlock( [ & ]( float x, float y ) {
+        const double leftDiff = x - statistics.meanX;
+        const double rightDiff = y - statistics.meanY;
+        
+        statistics.coMoment += leftDiff * rightDiff;
+        statistics.m2X += leftDiff * leftDiff;
+        statistics.m2Y += rightDiff * rightDiff;
+    } );
+    
+    return result;
+}
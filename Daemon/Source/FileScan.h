@@ -0,0 +1,34 @@
+/*
+  ==============================================================================
+
+    FileScan.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/CorrelationStatistics.h"
+
+struct ScanResult {
+    bool opened = false;
+    
+    // whole-file correlation, and the distribution of per-window values
+    Dsp::CorrelationStatistics< double > statistics;
+    Dsp::CorrelationSummary summary;
+};
+
+/*
+Scans a long file in fixed-size chunks of windows on numThreads threads.
+Chunk boundaries don't depend on the thread count and the chunks are reduced
+in file order, so the result is bit-for-bit the same for any thread count.
+*/
+ScanResult scanFile( const juce::File& file, int windowSize, int numThreads );
+
+/*
+Reference for checking scanFile(): the whole-file statistics computed as one
+stretch of audio, with a pass for the means and one for the moments. The
+summary is left empty.
+*/
+ScanResult scanFileSinglePass( const juce::File& file );
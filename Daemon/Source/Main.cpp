@@ -0,0 +1,404 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Headless analysis daemon: reads interleaved stereo PCM from stdin or a
+    named FIFO, runs it through the plugin's processBlock and publishes the
+    meter values as JSON lines on stdout. With --scan, analyses a whole file
+    on all cores instead.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/RealtimeAudit.h"
+#include "FileScan.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+
+struct Options {
+    double sampleRate = 48000.0;
+    int blockSize = 1024;
+    bool float32 = true;
+    bool decimated = false;
+
+    // publishing interval, and the most audio allowed to queue up in the pipe
+    int intervalMs = 100;
+    int maxLatencyMs = 500;
+
+    // "-" => stdin
+    juce::String input = "-";
+    
+    // offline scan of a single file
+    juce::String scan;
+    int windowSize = 4096;
+    int numThreads = juce::SystemStats::getNumCpus();
+    bool verify = false;
+};
+
+static Options parseOptions( const juce::ArgumentList& args ) {
+    Options options;
+
+    if ( args.containsOption( "--rate" ) )
+        options.sampleRate = juce::jmax( 8000.0, args.getValueForOption( "--rate" ).getDoubleValue() );
+    if ( args.containsOption( "--block" ) )
+        options.blockSize = juce::jlimit( 16, 16384, args.getValueForOption( "--block" ).getIntValue() );
+    if ( args.containsOption( "--format" ) )
+        options.float32 = args.getValueForOption( "--format" ) != "s16";
+    if ( args.containsOption( "--interval" ) )
+        options.intervalMs = juce::jmax( 1, args.getValueForOption( "--interval" ).getIntValue() );
+    if ( args.containsOption( "--max-latency" ) )
+        options.maxLatencyMs = juce::jmax( 0, args.getValueForOption( "--max-latency" ).getIntValue() );
+    if ( args.containsOption( "--input" ) )
+        options.input = args.getValueForOption( "--input" );
+
+    if ( args.containsOption( "--scan" ) )
+        options.scan = args.getValueForOption( "--scan" );
+    if ( args.containsOption( "--window" ) )
+        options.windowSize = juce::jmax( 16, args.getValueForOption( "--window" ).getIntValue() );
+    if ( args.containsOption( "--threads" ) )
+        options.numThreads = juce::jmax( 1, args.getValueForOption( "--threads" ).getIntValue() );
+    
+    options.decimated = args.containsOption( "--decimated" );
+    options.verify = args.containsOption( "--verify" );
+
+    return options;
+}
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop( int ) {
+    stopRequested = 1;
+}
+
+/*
+Blocking reader for stdin, a named FIFO or a file. A named FIFO is reopened
+when its writer goes away, so the daemon keeps running across producer
+restarts; a regular file ends at its end.
+*/
+class PcmInput {
+public:
+    explicit PcmInput( const juce::String& path ) : path( path ) {
+        fd = isStdin() ? STDIN_FILENO : open( path.toRawUTF8(), O_RDONLY );
+        inspect();
+    }
+
+    ~PcmInput() {
+        if ( fd >= 0 && ! isStdin() )
+            close( fd );
+    }
+
+    bool isOpen() const { return fd >= 0; }
+
+    bool read( char* dest, int numBytes ) {
+    /* reads exactly numBytes; false at the end of input or on a stop request */
+        for ( int done = 0; done < numBytes; ) {
+            if ( stopRequested )
+                return false;
+
+            const auto result = ::read( fd, dest + done, static_cast< size_t >( numBytes - done ) );
+
+            if ( result > 0 ) {
+                done += static_cast< int >( result );
+            } else if ( result < 0 && errno == EINTR ) {
+                continue;
+            } else if ( result == 0 && isFifo && ! isStdin() && reopen() ) {
+                // the partial frame of the previous writer is discarded
+                done = 0;
+            } else {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /* pipes and sockets; only their backlog says how far analysis is behind */
+    bool isStream() const { return isFifo || isSocket; }
+
+    int getNumBytesQueued() const {
+    /* on a regular file FIONREAD would report the rest of the file */
+        int numBytes = 0;
+        if ( ! isStream() )
+            return 0;
+
+        return ioctl( fd, FIONREAD, &numBytes ) == 0 ? numBytes : 0;
+    }
+
+    int reserveCapacity( int numBytes ) {
+    /* grows a pipe's buffer towards numBytes; returns the capacity, -1 if unknown */
+        requestedCapacity = numBytes;
+        return applyCapacity();
+    }
+
+private:
+    bool isStdin() const { return path == "-"; }
+
+    void inspect() {
+        struct stat info {};
+        isFifo = fd >= 0 && fstat( fd, &info ) == 0 && S_ISFIFO( info.st_mode );
+        isSocket = fd >= 0 && S_ISSOCK( info.st_mode );
+    }
+
+    int applyCapacity() {
+        if ( isFifo ) {
+            // beyond /proc/sys/fs/pipe-max-size this fails, and the pipe stays as it is
+            if ( requestedCapacity > 0 )
+                fcntl( fd, F_SETPIPE_SZ, requestedCapacity );
+
+            return fcntl( fd, F_GETPIPE_SZ );
+        }
+
+        if ( isSocket ) {
+            int size = 0;
+            socklen_t sizeLength = sizeof( size );
+            return getsockopt( fd, SOL_SOCKET, SO_RCVBUF, &size, &sizeLength ) == 0 ? size : -1;
+        }
+
+        return -1;
+    }
+
+    bool reopen() {
+        close( fd );
+        fd = open( path.toRawUTF8(), O_RDONLY );
+        inspect();
+
+        // a new writer can mean a new pipe with the default buffer
+        applyCapacity();
+        return fd >= 0;
+    }
+
+    juce::String path;
+    int fd = -1;
+    bool isFifo = false;
+    bool isSocket = false;
+    int requestedCapacity = 0;
+};
+
+static bool writeLine( const char* line, int length ) {
+/* never waits for a slow consumer of stdout; the line is dropped instead */
+    pollfd output{ STDOUT_FILENO, POLLOUT, 0 };
+    if ( poll( &output, 1, 0 ) != 1 || ( output.revents & POLLOUT ) == 0 )
+        return false;
+
+    return write( STDOUT_FILENO, line, static_cast< size_t >( length ) ) == length;
+}
+
+static void setParameter( juce::AudioProcessor& processor, const juce::String& id, bool value ) {
+    for ( auto* parameter : processor.getParameters() )
+        if ( auto* withId = dynamic_cast< juce::AudioProcessorParameterWithID* >( parameter ) )
+            if ( withId->paramID == id )
+                withId->setValueNotifyingHost( value ? 1.f : 0.f );
+}
+
+static bool isIdentical( const ScanResult& a, const ScanResult& b ) {
+    const auto& x = a.statistics;
+    const auto& y = b.statistics;
+    
+    return x.count == y.count && x.meanX == y.meanX && x.meanY == y.meanY &&
+           x.m2X == y.m2X && x.m2Y == y.m2Y && x.coMoment == y.coMoment &&
+           a.summary.numWindows == b.summary.numWindows &&
+           a.summary.minimum == b.summary.minimum && a.summary.maximum == b.summary.maximum &&
+           a.summary.histogram == b.summary.histogram;
+}
+
+static double getExactCorrelation( const Dsp::CorrelationStatistics< double >& statistics ) {
+    return statistics.coMoment / std::sqrt( statistics.m2X * statistics.m2Y );
+}
+
+static int runScanVerification( const Options& options, const juce::File& file ) {
+/* the chunked scan against one thread and against the single-pass reference */
+    const auto timeScan = [ & ]( int numThreads, double& seconds ) {
+        const auto startMs = juce::Time::getMillisecondCounterHiRes();
+        auto result = scanFile( file, options.windowSize, numThreads );
+        seconds = ( juce::Time::getMillisecondCounterHiRes() - startMs ) * 0.001;
+        return result;
+    };
+    
+    double oneThreadSeconds = 0.0, allThreadsSeconds = 0.0;
+    const auto oneThread = timeScan( 1, oneThreadSeconds );
+    const auto allThreads = timeScan( options.numThreads, allThreadsSeconds );
+    const auto reference = scanFileSinglePass( file );
+    
+    if ( ! oneThread.opened || ! allThreads.opened || ! reference.opened ) {
+        std::cerr << "Can't read " << file.getFullPathName() << std::endl;
+        return 1;
+    }
+    
+    // merging reorders the floating-point sums, so only near-equality is expected
+    const double correlationError = std::abs( getExactCorrelation( allThreads.statistics ) -
+                                              getExactCorrelation( reference.statistics ) );
+    const bool identical = isIdentical( oneThread, allThreads );
+    const bool passed = identical && correlationError < 1.0e-9 &&
+                        allThreads.statistics.count == reference.statistics.count;
+    
+    std::cout << "{\"file\":" << juce::JSON::toString( file.getFullPathName() )
+              << ",\"threads\":" << options.numThreads
+              << ",\"identical_to_one_thread\":" << ( identical ? "true" : "false" )
+              << ",\"single_pass_correlation_error\":" << juce::String( correlationError, 15 )
+              << ",\"seconds_one_thread\":" << juce::String( oneThreadSeconds, 3 )
+              << ",\"seconds\":" << juce::String( allThreadsSeconds, 3 )
+              << ",\"speedup\":" << juce::String( oneThreadSeconds / juce::jmax( 1.0e-6, allThreadsSeconds ), 2 )
+              << ",\"passed\":" << ( passed ? "true" : "false" ) << "}" << std::endl;
+    
+    return passed ? 0 : 1;
+}
+
+static int runScan( const Options& options ) {
+    const auto file = juce::File::getCurrentWorkingDirectory().getChildFile( options.scan );
+    
+    if ( options.verify )
+        return runScanVerification( options, file );
+    
+    const auto startMs = juce::Time::getMillisecondCounterHiRes();
+    const auto result = scanFile( file, options.windowSize, options.numThreads );
+    const auto elapsedMs = juce::Time::getMillisecondCounterHiRes() - startMs;
+    
+    if ( ! result.opened ) {
+        std::cerr << "Can't read " << file.getFullPathName() << std::endl;
+        return 1;
+    }
+    
+    juce::StringArray histogram;
+    for ( auto count : result.summary.histogram )
+        histogram.add( juce::String( count ) );
+    
+    std::cout << "{\"file\":" << juce::JSON::toString( file.getFullPathName() )
+              << ",\"windows\":" << result.summary.numWindows
+              << ",\"correlation\":" << juce::String( result.statistics.getCorrelation(), 6 )
+              << ",\"min\":" << juce::String( result.summary.minimum, 6 )
+              << ",\"max\":" << juce::String( result.summary.maximum, 6 )
+              << ",\"histogram\":[" << histogram.joinIntoString( "," ) << "]"
+              << ",\"seconds\":" << juce::String( elapsedMs * 0.001, 3 ) << "}" << std::endl;
+    
+    return 0;
+}
+
+//==============================================================================
+int main( int argc, char* argv[] )
+{
+    // the processor's parameter state needs a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const juce::ArgumentList args( argc, argv );
+    const auto options = parseOptions( args );
+    
+    if ( options.scan.isNotEmpty() )
+        return runScan( options );
+
+    struct sigaction action {};
+    action.sa_handler = requestStop;
+    sigaction( SIGINT, &action, nullptr );
+    sigaction( SIGTERM, &action, nullptr );
+    signal( SIGPIPE, SIG_IGN );
+
+    PcmInput input( options.input );
+    if ( ! input.isOpen() ) {
+        std::cerr << "Can't open " << options.input << std::endl;
+        return 1;
+    }
+
+    // everything the loop touches is allocated here, so memory stays constant
+    const int numChannels = 2;
+    const int bytesPerFrame = numChannels * ( options.float32 ? 4 : 2 );
+    const int blockBytes = options.blockSize * bytesPerFrame;
+    std::vector< char > raw( static_cast< size_t >( blockBytes ) );
+
+    juce::AudioBuffer< float > block( numChannels, options.blockSize );
+    juce::MidiBuffer midi;
+
+    SimpleCorrelationMeterAudioProcessor processor;
+    processor.setRateAndBufferSizeDetails( options.sampleRate, options.blockSize );
+    processor.prepareToPlay( options.sampleRate, options.blockSize );
+    setParameter( processor, "Decimated Analysis", options.decimated );
+
+    int maxQueuedBytes = juce::roundToInt( options.maxLatencyMs * 0.001 * options.sampleRate ) *
+                         bytesPerFrame;
+
+    // skipping needs the backlog to exceed maxQueuedBytes by a block, which
+    // the pipe's buffer has to be able to hold
+    if ( input.isStream() ) {
+        const int capacity = input.reserveCapacity( maxQueuedBytes + 2 * blockBytes );
+
+        if ( capacity > 0 && maxQueuedBytes + 2 * blockBytes > capacity ) {
+            maxQueuedBytes = juce::jmax( 0, capacity - 2 * blockBytes );
+            std::cerr << "--max-latency limited to "
+                      << juce::roundToInt( 1000.0 * maxQueuedBytes / bytesPerFrame / options.sampleRate )
+                      << " ms by the input buffer of " << capacity << " bytes" << std::endl;
+        }
+    }
+    const juce::int64 framesPerPublish = juce::jmax( 1, juce::roundToInt(
+        options.intervalMs * 0.001 * options.sampleRate / options.blockSize ) ) *
+        static_cast< juce::int64 >( options.blockSize );
+
+    juce::int64 framesProcessed = 0, framesDropped = 0, linesDropped = 0;
+    char line[ 512 ];
+
+    while ( ! stopRequested ) {
+        // when analysis falls behind, skip whole blocks to keep the latency bounded
+        while ( input.getNumBytesQueued() > maxQueuedBytes + blockBytes &&
+                input.read( raw.data(), blockBytes ) )
+            framesDropped += options.blockSize;
+
+        if ( ! input.read( raw.data(), blockBytes ) )
+            break;
+
+        // deinterleave and convert straight into the processing block
+        for ( int ch = 0; ch < numChannels; ch++ ) {
+            auto* dest = block.getWritePointer( ch );
+
+            if ( options.float32 )
+                juce::AudioDataConverters::convertFloat32LEToFloat(
+                    raw.data() + ch * 4, dest, options.blockSize, bytesPerFrame );
+            else
+                juce::AudioDataConverters::convertInt16LEToFloat(
+                    raw.data() + ch * 2, dest, options.blockSize, bytesPerFrame );
+        }
+
+        {
+            const RealtimeAudit::ScopedCallback callback;
+            processor.processBlock( block, midi );
+        }
+        framesProcessed += options.blockSize;
+
+        if ( framesProcessed % framesPerPublish != 0 )
+            continue;
+
+        const int length = std::snprintf(
+            line, sizeof( line ),
+            "{\"time\":%.3f,\"correlation_in\":%.4f,\"correlation_out\":%.4f,"
+            "\"min_in\":%.4f,\"min_out\":%.4f,\"rms_left\":%.2f,\"rms_right\":%.2f,"
+            "\"average_in\":%.4f,\"average_out\":%.4f,"
+            "\"dropped_frames\":%lld,\"dropped_lines\":%lld}\n",
+            ( framesProcessed + framesDropped ) / options.sampleRate,
+            processor.getCorrelationIn(), processor.getCorrelationOut(),
+            processor.getMinCorrelationIn(), processor.getMinCorrelationOut(),
+            processor.getRmsValue( 0 ), processor.getRmsValue( 1 ),
+            processor.getLongTermCorrelationIn(), processor.getLongTermCorrelationOut(),
+            static_cast< long long >( framesDropped ), static_cast< long long >( linesDropped ) );
+
+        if ( ! writeLine( line, length ) )
+            linesDropped++;
+    }
+
+    processor.releaseResources();
+    
+    if ( RealtimeAudit::enabled )
+        std::cerr << "Real-time audit: " << RealtimeAudit::getNumCallbacks()
+                  << " callbacks without violations, worst "
+                  << juce::String( RealtimeAudit::getWorstCallbackMs(), 3 ) << " ms" << std::endl;
+    
+    return 0;
+}
@@ -0,0 +1,272 @@
+/*
+  ==============================================================================
+
+    AnalysisDecimator.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Dsp {
+    /*
+    Decimator that brings the analysis path down to roughly 48 kHz through a
+    cascade of half-band stages, each halving the rate. Every other tap of a
+    half-band filter is zero, so a stage deals its input out into two streams:
+    one only meets the centre tap, the other the remaining taps, which are
+    symmetric and taken in pairs. That leaves about one multiply per four taps,
+    and only the retained output samples are ever computed.
+    
+    Each stage is a Kaiser-window half-band FIR that keeps the band up to 20 kHz
+    (scaled to the final rate) flat and rejects, by at least 70 dB, everything
+    that would fold back into it. The cascade is flat within 0.003 dB up to
+    20 kHz and at least 70 dB down from 28 kHz on at 48 kHz, so nothing aliases
+    into the band below 20 kHz (18.4 and 25.7 kHz at 44.1 kHz). The last stage
+    takes 16 multiplies per output sample, the earlier ones 5 or 6.
+    */
+    class AnalysisDecimator {
+    public:
+        static int chooseFactor( double sampleRate ) {
+        /* largest power of two that keeps the analysis rate at or above 44.1 kHz */
+            int factor = 1;
+            while ( factor < maxFactor && sampleRate / ( factor * 2 ) >= 44100.0 )
+                factor *= 2;
+
+            return factor;
+        }
+
+        void prepare( double sampleRate, int maximumBlockSize, int numChannels ) {
+            factor = chooseFactor( sampleRate );
+            maximumInputSize = maximumBlockSize;
+            maximumOutputSize = maximumBlockSize;
+
+            stages.clear();
+            stageOutputs.clear();
+
+            // the earlier stages only need to protect the band that survives the
+            // last one, so their transition bands are wide and their filters short
+            const double outputRate = sampleRate / factor;
+            for ( int stageFactor = factor; stageFactor > 1; stageFactor /= 2 ) {
+                const double stageOutputRate = outputRate * stageFactor / 2;
+
+                stages.emplace_back();
+                stages.back().prepare( passbandEdge * outputRate / stageOutputRate,
+                                       maximumOutputSize, numChannels );
+                maximumOutputSize = stages.back().getMaximumOutputSize();
+
+                if ( stageFactor > 2 )
+                    stageOutputs.emplace_back( numChannels, maximumOutputSize );
+            }
+
+            reset();
+        }
+
+        void reset() {
+            for ( auto& stage : stages )
+                stage.reset();
+        }
+
+        int getFactor() const { return factor; }
+
+        int getMaximumOutputSize() const { return maximumOutputSize; }
+
+        int process( const float* const* input, int numSamples, float* const* output ) {
+        /* decimate numSamples per channel into output; returns the number of output samples */
+            jassert( factor > 1 );
+            jassert( numSamples <= maximumInputSize );
+
+            for ( size_t s = 0; s < stages.size(); s++ ) {
+                float* const* stageOutput = s < stageOutputs.size()
+                                                ? stageOutputs[ s ].getArrayOfWritePointers()
+                                                : output;
+
+                numSamples = stages[ s ].process( input, numSamples, stageOutput );
+                input = stageOutput;
+            }
+
+            return numSamples;
+        }
+
+    private:
+        /*
+        One half-band stage. Input samples come in pairs ( a[ n ], b[ n ] ); with
+        4 * numPairs - 1 taps, g the nonzero side taps and c the centre tap, the
+        output is
+            y[ n ] = c * a[ n - numPairs + 1 ]
+                   + sum over j of g[ j ] * ( b[ n - j ] + b[ n - 2 * numPairs + 1 + j ] )
+        */
+        class HalfBandStage {
+        public:
+            void prepare( double passband, int maximumBlockSize, int numChannels ) {
+            /* passband as a fraction of the stage's output rate */
+                // the transition band is centred on a quarter of the input rate, so
+                // the stopband starts as far above it as the passband ends below;
+                // length estimates are loose for such short filters, so take the
+                // shortest one that actually reaches the attenuation
+                const double stopbandEdge = 0.5 * ( 1.0 - passband );
+                for ( numPairs = 1;; numPairs++ ) {
+                    design();
+                    if ( getMaximumGain( stopbandEdge, 0.5 ) <= maximumStopbandGain ||
+                         numPairs == maxPairs )
+                        break;
+                }
+
+                maximumOutputSize = maximumBlockSize / 2 + 1;
+                firstOfPairs.setSize( numChannels, numPairs - 1 + maximumOutputSize );
+                secondOfPairs.setSize( numChannels, 2 * numPairs - 1 + maximumOutputSize );
+                carry.resize( static_cast< size_t >( numChannels ) );
+                reset();
+            }
+
+            void reset() {
+                firstOfPairs.clear();
+                secondOfPairs.clear();
+                hasCarry = false;
+            }
+
+            int getMaximumOutputSize() const { return maximumOutputSize; }
+
+            int process( const float* const* input, int numSamples, float* const* output ) {
+                const int available = ( hasCarry ? 1 : 0 ) + numSamples;
+                const int numOutputs = available / 2;
+                const int firstHistory = numPairs - 1;
+                const int secondHistory = 2 * numPairs - 1;
+
+                for ( int ch = 0; ch < firstOfPairs.getNumChannels(); ch++ ) {
+                    const float* in = input[ ch ];
+                    float* a = firstOfPairs.getWritePointer( ch ) + firstHistory;
+                    float* b = secondOfPairs.getWritePointer( ch ) + secondHistory;
+
+                    // deal the input out into the two streams
+                    int n = 0, i = 0;
+                    if ( hasCarry && numOutputs > 0 ) {
+                        a[ 0 ] = carry[ static_cast< size_t >( ch ) ];
+                        b[ 0 ] = in[ 0 ];
+                        n = i = 1;
+                    }
+                    for ( ; n < numOutputs; n++, i += 2 ) {
+                        a[ n ] = in[ i ];
+                        b[ n ] = in[ i + 1 ];
+                    }
+
+                    if ( available % 2 != 0 && numSamples > 0 )
+                        carry[ static_cast< size_t >( ch ) ] = in[ numSamples - 1 ];
+
+                    // centre tap, then the side taps; two of them per pass over the
+                    // output save half of its loads and stores
+                    float* out = output[ ch ];
+                    const float* centreStream = a - firstHistory;
+                    for ( n = 0; n < numOutputs; n++ )
+                        out[ n ] = centreTap * centreStream[ n ];
+
+                    int j = 0;
+                    for ( ; j + 1 < numPairs; j += 2 ) {
+                        const float tap = sideTaps[ static_cast< size_t >( j ) ];
+                        const float nextTap = sideTaps[ static_cast< size_t >( j + 1 ) ];
+                        const float* newer = b - j;
+                        const float* older = b - secondHistory + j;
+                        for ( n = 0; n < numOutputs; n++ )
+                            out[ n ] += tap * ( newer[ n ] + older[ n ] ) +
+                                        nextTap * ( newer[ n - 1 ] + older[ n + 1 ] );
+                    }
+
+                    if ( j < numPairs ) {
+                        const float tap = sideTaps[ static_cast< size_t >( j ) ];
+                        const float* newer = b - j;
+                        const float* older = b - secondHistory + j;
+                        for ( n = 0; n < numOutputs; n++ )
+                            out[ n ] += tap * ( newer[ n ] + older[ n ] );
+                    }
+
+                    // keep the filter history for the next block
+                    std::memmove( a - firstHistory, a - firstHistory + numOutputs,
+                                  static_cast< size_t >( firstHistory ) * sizeof( float ) );
+                    std::memmove( b - secondHistory, b - secondHistory + numOutputs,
+                                  static_cast< size_t >( secondHistory ) * sizeof( float ) );
+                }
+
+                hasCarry = available % 2 != 0;
+                return numOutputs;
+            }
+
+        private:
+            void design() {
+            /* Kaiser-window half-band with 4 * numPairs - 1 taps, so that both ends are nonzero */
+                const int length = 4 * numPairs - 1;
+                const int centre = length / 2;
+
+                std::vector< float > window( static_cast< size_t >( length ) );
+                juce::dsp::WindowingFunction< float >::fillWindowingTables(
+                    window.data(), window.size(),
+                    juce::dsp::WindowingFunction< float >::kaiser, false, kaiserBeta );
+
+                // windowed sinc with its cutoff at a quarter of the input rate
+                sideTaps.resize( static_cast< size_t >( numPairs ) );
+                double sum = 0.5 * window[ static_cast< size_t >( centre ) ];
+                for ( int j = 0; j < numPairs; j++ ) {
+                    const int offset = getOffset( j );
+                    const double sinc = std::sin( juce::MathConstants< double >::halfPi * offset ) /
+                                        ( juce::MathConstants< double >::pi * offset );
+                    sideTaps[ static_cast< size_t >( j ) ] =
+                        static_cast< float >( sinc * window[ static_cast< size_t >( centre + offset ) ] );
+                    sum += 2.0 * sideTaps[ static_cast< size_t >( j ) ];
+                }
+
+                // unity gain at DC so RMS readings match the full-rate path
+                centreTap = static_cast< float >( 0.5 * window[ static_cast< size_t >( centre ) ] / sum );
+                for ( auto& tap : sideTaps )
+                    tap = static_cast< float >( tap / sum );
+            }
+
+            double getMaximumGain( double from, double to ) const {
+            /* largest magnitude response between two frequencies relative to the input rate */
+                double maximum = 0.0;
+                for ( int k = 0; k <= numGainPoints; k++ ) {
+                    const double frequency = from + ( to - from ) * k / numGainPoints;
+
+                    double gain = centreTap;
+                    for ( int j = 0; j < numPairs; j++ )
+                        gain += 2.0 * sideTaps[ static_cast< size_t >( j ) ] *
+                                std::cos( juce::MathConstants< double >::twoPi * frequency * getOffset( j ) );
+
+                    maximum = juce::jmax( maximum, std::abs( gain ) );
+                }
+
+                return maximum;
+            }
+
+            /* distance of side tap j from the centre tap */
+            int getOffset( int j ) const { return 2 * ( numPairs - j ) - 1; }
+
+            static constexpr int maxPairs = 64;
+            static constexpr int numGainPoints = 512;
+
+            int numPairs = 1;
+            int maximumOutputSize = 0;
+            float centreTap = 0.5f;
+            std::vector< float > sideTaps;
+
+            juce::AudioBuffer< float > firstOfPairs, secondOfPairs;
+            std::vector< float > carry;
+            bool hasCarry = false;
+        };
+
+        static constexpr int maxFactor = 16;
+
+        // relative to the decimated rate: 20 kHz at 48 kHz
+        static constexpr double passbandEdge = 20000.0 / 48000.0;
+
+        // -70 dB; the window's own sidelobes sit a little lower, at about -76 dB
+        static constexpr double maximumStopbandGain = 3.1623e-4;
+        static constexpr float kaiserBeta = 0.1102f * ( 76.f - 8.7f );
+
+        int factor = 1;
+        int maximumInputSize = 0;
+        int maximumOutputSize = 0;
+
+        std::vector< HalfBandStage > stages;
+        std::vector< juce::AudioBuffer< float > > stageOutputs;
+    };
+}
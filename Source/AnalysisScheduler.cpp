@@ -0,0 +1,241 @@
+/*
+  ==============================================================================
+
+    AnalysisScheduler.cpp
+
+  ==============================================================================
+*/
+
+#include "AnalysisScheduler.h"
+
+#if JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#else
+ #include <cerrno>
+ #include <semaphore.h>
+#endif
+
+/*
+Counting semaphore whose signal() is a single atomic increment unless a
+worker is asleep, so the audio thread can wake the pool. juce::WaitableEvent
+takes a mutex in signal(), which the audio thread must not.
+*/
+class AnalysisScheduler::Semaphore {
+public:
+#if JUCE_MAC || JUCE_IOS
+    Semaphore() : semaphore( dispatch_semaphore_create( 0 ) ) {}
+    ~Semaphore() { dispatch_release( semaphore ); }
+    
+    void signal() { dispatch_semaphore_signal( semaphore ); }
+    void wait() { dispatch_semaphore_wait( semaphore, DISPATCH_TIME_FOREVER ); }
+    
+private:
+    dispatch_semaphore_t semaphore;
+#else
+    Semaphore() { sem_init( &semaphore, 0, 0 ); }
+    ~Semaphore() { sem_destroy( &semaphore ); }
+    
+    void signal() { sem_post( &semaphore ); }
+    void wait() {
+        while ( sem_wait( &semaphore ) != 0 && errno == EINTR ) {}
+    }
+    
+private:
+    sem_t semaphore;
+#endif
+};
+
+class AnalysisScheduler::Worker : public juce::Thread {
+public:
+    Worker( AnalysisScheduler& owner, int index ) :
+            juce::Thread( "Correlation analysis " + juce::String( index ) ),
+            owner( owner ) {}
+    
+    void run() override {
+        // at least one wake-up per queued client; the destructor adds one per worker
+        for ( ;; ) {
+            owner.numQueued->wait();
+            
+            if ( threadShouldExit() )
+                return;
+            
+            owner.runQueued();
+        }
+    }
+    
+private:
+    AnalysisScheduler& owner;
+};
+
+void AnalysisScheduler::Client::requestAnalysis() {
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    
+    auto current = state.load( std::memory_order_acquire );
+    
+    for ( ;; ) {
+        // already waiting for a worker
+        if ( current == queued || current == runningAndRequested )
+            return;
+        
+        // a running job is repeated by its worker instead of being queued again
+        const int next = current == idle ? queued : runningAndRequested;
+        if ( state.compare_exchange_weak( current, next, std::memory_order_acq_rel ) )
+            break;
+    }
+    
+    if ( current != idle )
+        return;
+    
+    if ( auto* owner = scheduler.load( std::memory_order_acquire ) )
+        owner->enqueue( *this );
+    else
+        state.store( idle, std::memory_order_release );
+}
+
+double AnalysisScheduler::Client::getWorkerTimeMs() const {
+    return juce::Time::highResolutionTicksToSeconds( workerTicks.load() ) * 1000.0;
+}
+
+AnalysisScheduler::ReadyQueue::ReadyQueue() {
+    for ( size_t i = 0; i < slots.size(); i++ )
+        slots[ i ].sequence.store( i, std::memory_order_relaxed );
+}
+
+bool AnalysisScheduler::ReadyQueue::push( Client* client ) {
+    auto position = pushPosition.load( std::memory_order_relaxed );
+    
+    for ( ;; ) {
+        auto& slot = slots[ position % slots.size() ];
+        const auto sequence = slot.sequence.load( std::memory_order_acquire );
+        const auto difference = static_cast< std::ptrdiff_t >( sequence - position );
+        
+        if ( difference == 0 ) {
+            if ( pushPosition.compare_exchange_weak( position, position + 1,
+                                                     std::memory_order_relaxed ) ) {
+                slot.client = client;
+                slot.sequence.store( position + 1, std::memory_order_release );
+                return true;
+            }
+        } else if ( difference < 0 ) {
+            return false;
+        } else {
+            position = pushPosition.load( std::memory_order_relaxed );
+        }
+    }
+}
+
+bool AnalysisScheduler::ReadyQueue::pop( Client*& client ) {
+    auto position = popPosition.load( std::memory_order_relaxed );
+    
+    for ( ;; ) {
+        auto& slot = slots[ position % slots.size() ];
+        const auto sequence = slot.sequence.load( std::memory_order_acquire );
+        const auto difference = static_cast< std::ptrdiff_t >( sequence - ( position + 1 ) );
+        
+        if ( difference == 0 ) {
+            if ( popPosition.compare_exchange_weak( position, position + 1,
+                                                    std::memory_order_relaxed ) ) {
+                client = slot.client;
+                slot.sequence.store( position + slots.size(), std::memory_order_release );
+                return true;
+            }
+        } else if ( difference < 0 ) {
+            return false;
+        } else {
+            position = popPosition.load( std::memory_order_relaxed );
+        }
+    }
+}
+
+AnalysisScheduler::AnalysisScheduler() : numQueued( std::make_unique< Semaphore >() ) {
+    // leave a core for the host's audio threads
+    const int numWorkers = juce::jmax( 1, juce::SystemStats::getNumCpus() - 1 );
+    
+    for ( int i = 0; i < numWorkers; i++ ) {
+        auto* worker = workers.add( new Worker( *this, i ) );
+        worker->startThread( juce::Thread::Priority::low );
+    }
+}
+
+AnalysisScheduler::~AnalysisScheduler() {
+    for ( auto* worker : workers )
+        worker->signalThreadShouldExit();
+    
+    for ( int i = 0; i < workers.size(); i++ )
+        numQueued->signal();
+    
+    for ( auto* worker : workers )
+        worker->stopThread( 1000 );
+}
+
+bool AnalysisScheduler::registerClient( Client& client ) {
+    // a client is only ever in one queue once, so the queues can't overflow
+    // as long as there are no more clients than slots
+    int current = numClients.load();
+    do {
+        if ( current >= maxClients )
+            return false;
+    } while ( ! numClients.compare_exchange_weak( current, current + 1 ) );
+    
+    client.scheduler.store( this, std::memory_order_release );
+    return true;
+}
+
+void AnalysisScheduler::unregisterClient( Client& client ) {
+    // a client that was turned away never counted
+    if ( client.scheduler.exchange( nullptr, std::memory_order_acq_rel ) == nullptr )
+        return;
+    
+    // a queued job still gets run, so the client is idle soon
+    while ( client.state.load( std::memory_order_acquire ) != Client::idle )
+        juce::Thread::sleep( 1 );
+    
+    numClients--;
+}
+
+void AnalysisScheduler::enqueue( Client& client ) {
+    auto& queue = client.visible.load() ? visibleQueue : hiddenQueue;
+    
+    // can't fail while registerClient() keeps the clients within the slots, but
+    // a client left marked queued would make unregisterClient() wait forever
+    if ( ! queue.push( &client ) ) {
+        jassertfalse;
+        client.state.store( Client::idle, std::memory_order_release );
+        return;
+    }
+    
+    numQueued->signal();
+}
+
+void AnalysisScheduler::runQueued() {
+    // a pop fails while another producer is still filling an earlier slot; that
+    // producer wakes a worker once it's done, and that worker takes both clients
+    Client* client = nullptr;
+    
+    // clients with an editor on screen go first
+    while ( visibleQueue.pop( client ) || hiddenQueue.pop( client ) )
+        run( *client );
+}
+
+void AnalysisScheduler::run( Client& client ) {
+    client.state.store( Client::running );
+    
+    // pairs with the fence in requestAnalysis(): either the job sees the data
+    // published before a request, or the request sees the client running
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    
+    for ( ;; ) {
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        client.runAnalysis();
+        client.workerTicks += juce::Time::getHighResolutionTicks() - startTicks;
+        client.numJobs++;
+        
+        // more work was requested while the job ran: repeat it on this worker
+        int expected = Client::running;
+        if ( client.state.compare_exchange_strong( expected, Client::idle,
+                                                   std::memory_order_acq_rel ) )
+            return;
+        
+        client.state.store( Client::running, std::memory_order_release );
+    }
+}
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    AnalysisScheduler.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+Process-wide pool of worker threads that runs the heavy metering work of every
+plugin instance, so that instances don't each need a thread of their own.
+Obtain it through juce::SharedResourcePointer< AnalysisScheduler >.
+*/
+class AnalysisScheduler {
+public:
+    class Client {
+    public:
+        virtual ~Client() = default;
+        
+        /* called on a worker thread, never concurrently with itself */
+        virtual void runAnalysis() = 0;
+        
+        /*
+        lock-free, safe to call from the audio thread; only the first request
+        after a job has started queues the client again
+        */
+        void requestAnalysis();
+        
+        /* clients with a visible editor are serviced before the others */
+        void setAnalysisVisible( bool isVisible ) { visible.store( isVisible ); }
+        
+        // instrumentation
+        double getWorkerTimeMs() const;
+        int getNumAnalysisJobs() const { return numJobs.load(); }
+        
+    private:
+        friend class AnalysisScheduler;
+        
+        enum State { idle, queued, running, runningAndRequested };
+        
+        std::atomic< int > state{ idle };
+        std::atomic< bool > visible{ false };
+        std::atomic< AnalysisScheduler* > scheduler{ nullptr };
+        
+        std::atomic< juce::int64 > workerTicks{ 0 };
+        std::atomic< int > numJobs{ 0 };
+    };
+    
+    AnalysisScheduler();
+    ~AnalysisScheduler();
+    
+    /*
+    the client must stay alive until unregisterClient() has returned, and its
+    audio thread must have stopped requesting work by then; returns false, and
+    the client's requests do nothing, once maxClients are registered
+    */
+    bool registerClient( Client& client );
+    void unregisterClient( Client& client );
+    
+    int getNumWorkers() const { return workers.size(); }
+    
+    // each client is queued at most once, so this bounds the size of the queues
+    static constexpr int maxClients = 1024;
+    
+private:
+    class Worker;
+    class Semaphore;
+    
+    /*
+    Bounded multi-producer, multi-consumer queue of clients (D. Vyukov's
+    sequenced ring): every slot carries the position it's next valid for, so
+    producers and consumers only contend on a single compare-and-swap.
+    */
+    class ReadyQueue {
+    public:
+        ReadyQueue();
+        
+        bool push( Client* client );
+        bool pop( Client*& client );
+        
+    private:
+        struct Slot {
+            std::atomic< size_t > sequence{ 0 };
+            Client* client = nullptr;
+        };
+        
+        std::array< Slot, maxClients > slots;
+        std::atomic< size_t > pushPosition{ 0 };
+        std::atomic< size_t > popPosition{ 0 };
+    };
+    
+    void enqueue( Client& client );
+    void runQueued();
+    void run( Client& client );
+    
+    ReadyQueue visibleQueue, hiddenQueue;
+    std::unique_ptr< Semaphore > numQueued;
+    std::atomic< int > numClients{ 0 };
+    
+    juce::OwnedArray< Worker > workers;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisScheduler)
+};
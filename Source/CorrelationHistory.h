@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    CorrelationHistory.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Dsp {
+    /*
+    Mean of per-block correlation values weighted by block length, collected
+    until one history bin of audio is complete. Cheap enough for the audio
+    thread, so only completed bins need to leave it.
+    */
+    class CorrelationBin {
+    public:
+        void reset() {
+            sum = 0.0;
+            numSamples = 0;
+        }
+        
+        /* returns true once the bin holds at least binLength samples */
+        bool add( float correlation, int blockSize, int binLength ) {
+            sum += static_cast< double >( correlation ) * blockSize;
+            numSamples += blockSize;
+            
+            return numSamples >= binLength;
+        }
+        
+        float getMean() const {
+            return numSamples > 0 ? static_cast< float >( sum / numSamples ) : 0.f;
+        }
+        
+    private:
+        double sum = 0.0;
+        int numSamples = 0;
+    };
+    
+    /*
+    Long-term correlation average over the last numBins completed bins.
+    */
+    class CorrelationHistory {
+    public:
+        void reset( int binsToAverage ) {
+            numBins = juce::jlimit( 1, maxBins, binsToAverage );
+            reset();
+        }
+        
+        void reset() {
+            bins.fill( 0.f );
+            numFilledBins = 0;
+            nextBin = 0;
+        }
+        
+        void add( float binMean ) {
+            bins[ nextBin ] = binMean;
+            nextBin = ( nextBin + 1 ) % numBins;
+            numFilledBins = juce::jmin( numFilledBins + 1, numBins );
+        }
+        
+        float getAverage() const {
+        /* returns -2.0 (sentinel value) until the first bin is complete */
+            if ( numFilledBins == 0 )
+                return -2.f;
+            
+            float sum = 0.f;
+            for ( int i = 0; i < numFilledBins; i++ )
+                sum += bins[ i ];
+            
+            return sum / numFilledBins;
+        }
+        
+    private:
+        // 30 s of history in 1 s bins
+        static constexpr int maxBins = 30;
+        
+        std::array< float, maxBins > bins{};
+        int numBins = 30;
+        int numFilledBins = 0;
+        int nextBin = 0;
+    };
+}
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "GuiResources.h"
 
 namespace Gui {
     class CorrelationMeter : public juce::Component {
@@ -21,12 +22,117 @@ namespace Gui {
         void paint( juce::Graphics& g ) override {
             using namespace juce;
             
+            // title, scale and labels come prerendered from the shared cache
+            const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+            if ( background.isNull() || backgroundScale != scale ) {
+                background = resources->getImage( "CorrelationMeter " + name,
+                                                  getWidth(), getHeight(), scale,
+                                                  [ this ]( Graphics& bg ) { paintBackground( bg ); } );
+                backgroundScale = scale;
+            }
+            g.drawImage( background, getLocalBounds().toFloat() );
+            
+            const auto& titleBar = layout.titleBar;
+            const auto& meterDisplay = layout.meterDisplay;
+            const auto& corrTextBox = layout.minimumLabel;
+            int textHeight = g.getCurrentFont().getHeight();
+            
+            g.setColour( Colours::white.withBrightness( 0.5f ) );
+            
+            // long-term average, once enough audio has been analysed
+            if ( longTermCorrelation != -2.f ) {
+                String averageStr( "Average: " );
+                averageStr << String( longTermCorrelation, 2, false );
+                g.drawFittedText( averageStr,
+                                  titleBar.getX(),
+                                  titleBar.getY() + textHeight,
+                                  titleBar.getWidth() * 0.93,
+                                  textHeight,
+                                  Justification::centredRight,
+                                  1 );
+            }
+                
+            // mark minimum correlation if value is different from sentinel value
+            if ( minimumCorrelation != -2.f ){
+                // shade of red
+                g.setColour( Colour( 209, 63, 63 ) );
+                g.fillRoundedRectangle(
+                    meterDisplay.getX() +
+                        meterDisplay.getWidth() * 0.5 +
+                        meterDisplay.getWidth() * minimumCorrelation * 0.5 - 1,
+                    meterDisplay.getY(),
+                    2,
+                    meterDisplay.getHeight(),
+                    0.5f );
+                
+                String minCorrStr( minimumCorrelation, 2, false );
+                g.drawFittedText( minCorrStr,
+                                  corrTextBox.getX() + corrTextBox.getWidth(),
+                                  corrTextBox.getY(),
+                                  g.getCurrentFont().getStringWidth( minCorrStr ),
+                                  corrTextBox.getHeight(),
+                                  Justification::centred,
+                                  1 );
+            }
+            
+            // draw the needle of the meter
+            g.setColour( Colours::white );
+            const auto scaledX = jmap( coefficient, -1.f, 1.f, 0.f,
+                static_cast< float >( meterDisplay.getWidth() ) );
+            g.fillRoundedRectangle( meterDisplay.getX() + scaledX - 1,
+                                    meterDisplay.getY(),
+                                    2,
+                                    meterDisplay.getHeight(),
+                                    5.f );
+        }
+        
+        void resized() override {
+            // measured with the default font, which is what both paint methods draw with
+            layout = getLayout( juce::Font() );
+            background = {};
+        }
+        
+        void setCoefficient( const float value ) { coefficient = value; }
+        void setMinimumCorrelation( const float value ) { minimumCorrelation = value; }
+        void setLongTermCorrelation( const float value ) { longTermCorrelation = value; }
+        juce::String getName() { return name; }
+        
+    private:
+        struct Layout {
+            juce::Rectangle< float > titleBar, meterDisplay;
+            juce::Rectangle< int > minimumLabel;
+        };
+        
+        Layout getLayout( const juce::Font& font ) const {
             auto bounds = getLocalBounds().toFloat();
+            int textHeight = font.getHeight();
             
+            Layout layout;
+            layout.titleBar = bounds.removeFromTop( textHeight * 1.5f );
+            layout.meterDisplay = bounds.reduced(
+                bounds.getWidth() * 0.1, bounds.getHeight() * 0.42 );
+            
+            const auto& meterDisplay = layout.meterDisplay;
+            int corrStrWidth = font.getStringWidth( minimumLabelText );
+            layout.minimumLabel = juce::Rectangle< int >( meterDisplay.getX() +
+                                                              meterDisplay.getWidth() * 0.5 -
+                                                          corrStrWidth * 0.5,
+                                                          meterDisplay.getY() +
+                                                              meterDisplay.getHeight() * 1.75,
+                                                          corrStrWidth,
+                                                          textHeight );
+            return layout;
+        }
+        
+        void paintBackground( juce::Graphics& g ) const {
+        /* everything that doesn't change with the measured values */
+            using namespace juce;
+            
+            const auto& titleBar = layout.titleBar;
+            const auto& meterDisplay = layout.meterDisplay;
             int textHeight = g.getCurrentFont().getHeight();
             
             g.setColour( Colours::white.withBrightness( 0.5f ) );
-            auto titleBar = bounds.removeFromTop( textHeight * 1.5f );
             g.drawFittedText( name,
                               titleBar.getX() + titleBar.getWidth() * 0.07,
                               titleBar.getY() + textHeight,
@@ -35,9 +141,6 @@ namespace Gui {
                               Justification::centred,
                               1 );
             
-            auto meterDisplay = bounds.reduced(
-                bounds.getWidth() * 0.1, bounds.getHeight() * 0.42 );
-            
             g.setColour( Colours::white.withBrightness( 0.4f ) );
             g.fillRoundedRectangle( meterDisplay, 3.f );
             
@@ -65,47 +168,12 @@ namespace Gui {
                 2,
                 meterDisplay.getHeight(),
                 0.5f );
-                
-            String minimumCorrelationString( "Current minimum: " );
-            int corrStrWidth =
-                g.getCurrentFont().getStringWidth( minimumCorrelationString );
-            Rectangle < int > corrTextBox( meterDisplay.getX() +
-                                               meterDisplay.getWidth() * 0.5 -
-                                           corrStrWidth * 0.5,
-                                           meterDisplay.getY() +
-                                               meterDisplay.getHeight() * 1.75,
-                                           corrStrWidth,
-                                           textHeight );
-            g.drawFittedText( minimumCorrelationString,
-                              corrTextBox,
+            
+            g.drawFittedText( minimumLabelText,
+                              layout.minimumLabel,
                               textHeight,
                               Justification::centred, 1 );
-                
-            // mark minimum correlation if value is different from sentinel value
-            if ( minimumCorrelation != -2.f ){
-                // shade of red
-                g.setColour( Colour( 209, 63, 63 ) );
-                g.fillRoundedRectangle(
-                    meterDisplay.getX() +
-                        meterDisplay.getWidth() * 0.5 +
-                        meterDisplay.getWidth() * minimumCorrelation * 0.5 - 1,
-                    meterDisplay.getY(),
-                    2,
-                    meterDisplay.getHeight(),
-                    0.5f );
-                
-                String minCorrStr( minimumCorrelation, 2, false );
-                g.drawFittedText( minCorrStr,
-                                  corrTextBox.getX() + corrTextBox.getWidth(),
-                                  corrTextBox.getY(),
-                                  g.getCurrentFont().getStringWidth( minCorrStr ),
-                                  corrTextBox.getHeight(),
-                                  Justification::centred,
-                                  1 );
-            }
-            
             
-            g.setColour( Colours::white.withBrightness( 0.5f ) );
             std::vector< float > positions{ -1.f, -0.5f, 0.f, 0.5f, 1.f };
             for( auto pos : positions ) {
                 String str( pos, 1, false );
@@ -121,27 +189,18 @@ namespace Gui {
                 
                 g.drawFittedText( str, r, juce::Justification::centred, 1 );
             }
-            
-            
-            
-            // draw the needle of the meter
-            g.setColour( Colours::white );
-            const auto scaledX = jmap( coefficient, -1.f, 1.f, 0.f,
-                static_cast< float >( meterDisplay.getWidth() ) );
-            g.fillRoundedRectangle( meterDisplay.getX() + scaledX - 1,
-                                    meterDisplay.getY(),
-                                    2,
-                                    meterDisplay.getHeight(),
-                                    5.f );
         }
         
-        void setCoefficient( const float value ) { coefficient = value; }
-        void setMinimumCorrelation( const float value ) { minimumCorrelation = value; }
-        juce::String getName() { return name; }
+        const juce::String minimumLabelText{ "Current minimum: " };
         
-    private:
         juce::String name;
+        Layout layout;
         float coefficient = 0.f;
         float minimumCorrelation = -2.f;
+        float longTermCorrelation = -2.f;
+        
+        juce::SharedResourcePointer< GuiResources > resources;
+        juce::Image background;
+        float backgroundScale = 0.f;
     };
 }
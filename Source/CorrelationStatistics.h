@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    CorrelationStatistics.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Dsp {
+    /*
+    Sufficient statistics for the Pearson correlation of two signals: sample
+    count, means and (co-)moments about the means. Statistics of separate
+    stretches of audio merge associatively (Chan et al.), so a long file can
+    be analysed in chunks and reduced afterwards.
+    */
+    template < typename Accumulator >
+    struct CorrelationStatistics {
+        juce::int64 count = 0;
+        Accumulator meanX = 0, meanY = 0;
+        Accumulator m2X = 0, m2Y = 0, coMoment = 0;
+        
+        static CorrelationStatistics fromSamples( const float* x, const float* y, int numSamples ) {
+            CorrelationStatistics statistics;
+            if ( numSamples <= 0 )
+                return statistics;
+            
+            statistics.count = numSamples;
+            
+            // get mean for left and right channels
+            for ( int i = 0; i < numSamples; i++ ) {
+                statistics.meanX += x[ i ];
+                statistics.meanY += y[ i ];
+            }
+            statistics.meanX /= numSamples;
+            statistics.meanY /= numSamples;
+            
+            // second pass about the means, to avoid cancellation
+            for ( int i = 0; i < numSamples; i++ ) {
+                const Accumulator leftDiff = x[ i ] - statistics.meanX;
+                const Accumulator rightDiff = y[ i ] - statistics.meanY;
+                
+                statistics.coMoment += leftDiff * rightDiff;
+                statistics.m2X += leftDiff * leftDiff;
+                statistics.m2Y += rightDiff * rightDiff;
+            }
+            
+            return statistics;
+        }
+        
+        void merge( const CorrelationStatistics& other ) {
+            if ( other.count == 0 )
+                return;
+            
+            if ( count == 0 ) {
+                *this = other;
+                return;
+            }
+            
+            const auto total = static_cast< Accumulator >( count + other.count );
+            const auto weight = static_cast< Accumulator >( count ) *
+                                static_cast< Accumulator >( other.count ) / total;
+            const Accumulator deltaX = other.meanX - meanX;
+            const Accumulator deltaY = other.meanY - meanY;
+            
+            meanX += deltaX * static_cast< Accumulator >( other.count ) / total;
+            meanY += deltaY * static_cast< Accumulator >( other.count ) / total;
+            
+            m2X += other.m2X + deltaX * deltaX * weight;
+            m2Y += other.m2Y + deltaY * deltaY * weight;
+            coMoment += other.coMoment + deltaX * deltaY * weight;
+            
+            count += other.count;
+        }
+        
+        float getCorrelation() const {
+            const auto correlation = static_cast< float >( coMoment / std::sqrt( m2X * m2Y ) );
+            
+            // if correlation within range
+            if ( correlation >= -1.f && correlation <= 1.f )
+                return correlation;
+            
+            // NaN guard
+            return 0.f;
+        }
+    };
+    
+    /*
+    Distribution of per-window correlation values. Holds only counts and
+    extremes, so merging is exact in any order.
+    */
+    struct CorrelationSummary {
+        static constexpr int numBins = 20;
+        
+        juce::int64 numWindows = 0;
+        float minimum = 1.f;
+        float maximum = -1.f;
+        std::array< juce::int64, numBins > histogram{};
+        
+        void add( float correlation ) {
+            numWindows++;
+            minimum = juce::jmin( minimum, correlation );
+            maximum = juce::jmax( maximum, correlation );
+            
+            const int bin = static_cast< int >( ( correlation + 1.f ) * 0.5f * numBins );
+            histogram[ static_cast< size_t >( juce::jlimit( 0, numBins - 1, bin ) ) ]++;
+        }
+        
+        void merge( const CorrelationSummary& other ) {
+            numWindows += other.numWindows;
+            minimum = juce::jmin( minimum, other.minimum );
+            maximum = juce::jmax( maximum, other.maximum );
+            
+            for ( size_t i = 0; i < histogram.size(); i++ )
+                histogram[ i ] += other.histogram[ i ];
+        }
+    };
+}
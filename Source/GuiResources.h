@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    GuiResources.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Gui {
+    /*
+    Process-wide cache of prerendered images (meter backgrounds, gradient strips
+    and their fixed labels), shared by all open editors. Obtain it through
+    juce::SharedResourcePointer< Gui::GuiResources >; it is released with the
+    last editor. Message thread only.
+    */
+    class GuiResources {
+    public:
+        using Renderer = std::function< void( juce::Graphics& ) >;
+        
+        juce::Image getImage( const juce::String& name, int width, int height,
+                              float scale, const Renderer& render ) {
+        /* cached image of the given logical size and pixel scale, rendered on first use */
+            const auto key = name + " " + juce::String( width ) + "x" + juce::String( height ) +
+                             "@" + juce::String( scale, 2 );
+            
+            auto found = images.find( key );
+            if ( found != images.end() )
+                return found->second;
+            
+            purgeUnused();
+            
+            juce::Image image( juce::Image::ARGB,
+                               juce::jmax( 1, juce::roundToInt( width * scale ) ),
+                               juce::jmax( 1, juce::roundToInt( height * scale ) ),
+                               true );
+            {
+                juce::Graphics g( image );
+                g.addTransform( juce::AffineTransform::scale( scale ) );
+                render( g );
+            }
+            
+            images[ key ] = image;
+            return image;
+        }
+        
+    private:
+        void purgeUnused() {
+        /* drop images that no component is holding on to anymore */
+            if ( images.size() < maxImages )
+                return;
+            
+            for ( auto it = images.begin(); it != images.end(); ) {
+                if ( it->second.getReferenceCount() <= 1 )
+                    it = images.erase( it );
+                else
+                    ++it;
+            }
+        }
+        
+        static constexpr size_t maxImages = 32;
+        
+        std::map< juce::String, juce::Image > images;
+    };
+}
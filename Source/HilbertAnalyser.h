@@ -0,0 +1,198 @@
+/*
+  ==============================================================================
+
+    HilbertAnalyser.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace Dsp {
+    /*
+    Analytic signal of both channels through an IIR Hilbert pair (two chains of
+    four second-order allpasses, 90 degrees apart over nearly the whole band).
+    The allpasses only look two samples back, so even and odd samples form
+    independent chains: a pair of samples runs through both chains of both
+    channels in eight lanes of SIMD registers, and neither sample waits on the
+    other.
+    
+    Per sample it yields the instantaneous phase difference between the
+    channels; per block, the envelope-weighted coherence (mean cosine of the
+    phase difference) and an envelope-weighted histogram of the difference.
+    */
+    class HilbertAnalyser {
+    public:
+        static constexpr int numHistogramBins = 16;
+        
+        struct Result {
+            float coherence = 0.f;
+            
+            // phase of the right channel minus that of the left, from -pi to pi,
+            // so positive when the right channel leads; the weights sum to 1 when
+            // there was any signal
+            std::array< float, numHistogramBins > histogram{};
+        };
+        
+        HilbertAnalyser() {
+            static constexpr float realChain[ numStages ] =
+                { 0.6923878f, 0.9360654322959f, 0.9882295226860f, 0.9987488452737f };
+            static constexpr float imaginaryChain[ numStages ] =
+                { 0.4021921162426f, 0.8561710882420f, 0.9722909545651f, 0.9952884791278f };
+            
+            // lanes: left real, left imaginary, right real, right imaginary; twice
+            for ( int stage = 0; stage < numStages; stage++ )
+                for ( int lane = 0; lane < numLanes; lane++ )
+                    coefficients[ stage ][ lane ] = lane % 2 == 0
+                        ? realChain[ stage ] * realChain[ stage ]
+                        : imaginaryChain[ stage ] * imaginaryChain[ stage ];
+        }
+        
+        void reset() {
+            std::fill( &previousIn[ 0 ][ 0 ], &previousIn[ 0 ][ 0 ] + numStages * numLanes, 0.f );
+            std::fill( &previousOut[ 0 ][ 0 ], &previousOut[ 0 ][ 0 ] + numStages * numLanes, 0.f );
+            delayedLeft = delayedRight = 0.f;
+        }
+        
+        void process( const float* left, const float* right, int numSamples, Result& result ) {
+            Sums sums;
+            
+            // the filter state stays in registers for the whole block
+            Vector c[ numStages ][ numVectors ], in[ numStages ][ numVectors ], out[ numStages ][ numVectors ];
+            for ( int stage = 0; stage < numStages; stage++ ) {
+                for ( int v = 0; v < numVectors; v++ ) {
+                    c[ stage ][ v ] = Vector::fromRawArray( coefficients[ stage ] + v * vectorSize );
+                    in[ stage ][ v ] = Vector::fromRawArray( previousIn[ stage ] + v * vectorSize );
+                    out[ stage ][ v ] = Vector::fromRawArray( previousOut[ stage ] + v * vectorSize );
+                }
+            }
+            
+            int i = 0;
+            for ( ; i + 1 < numSamples; i += 2 ) {
+                alignas( 32 ) float lanes[ numLanes ] = { left[ i ], left[ i ], right[ i ], right[ i ],
+                                                          left[ i + 1 ], left[ i + 1 ],
+                                                          right[ i + 1 ], right[ i + 1 ] };
+                
+                // y[ n ] = a^2 * ( x[ n ] + y[ n - 2 ] ) - x[ n - 2 ]
+                for ( int v = 0; v < numVectors; v++ ) {
+                    auto x = Vector::fromRawArray( lanes + v * vectorSize );
+                    
+                    for ( int stage = 0; stage < numStages; stage++ ) {
+                        const auto y = c[ stage ][ v ] * ( x + out[ stage ][ v ] ) - in[ stage ][ v ];
+                        in[ stage ][ v ] = x;
+                        out[ stage ][ v ] = y;
+                        x = y;
+                    }
+                    
+                    x.copyToRawArray( lanes + v * vectorSize );
+                }
+                
+                // the real chain needs one more sample of delay to line up
+                sums.add( delayedLeft, lanes[ 1 ], delayedRight, lanes[ 3 ] );
+                sums.add( lanes[ 0 ], lanes[ 5 ], lanes[ 2 ], lanes[ 7 ] );
+                delayedLeft = lanes[ 4 ];
+                delayedRight = lanes[ 6 ];
+            }
+            
+            for ( int stage = 0; stage < numStages; stage++ ) {
+                for ( int v = 0; v < numVectors; v++ ) {
+                    in[ stage ][ v ].copyToRawArray( previousIn[ stage ] + v * vectorSize );
+                    out[ stage ][ v ].copyToRawArray( previousOut[ stage ] + v * vectorSize );
+                }
+            }
+            
+            if ( i < numSamples ) {
+                // the odd sample out goes through the first chain alone, and the
+                // other chain comes first in the next block
+                float lanes[ chainLanes ] = { left[ i ], left[ i ], right[ i ], right[ i ] };
+                for ( int stage = 0; stage < numStages; stage++ ) {
+                    for ( int lane = 0; lane < chainLanes; lane++ ) {
+                        const float y = coefficients[ stage ][ lane ] *
+                                            ( lanes[ lane ] + previousOut[ stage ][ lane ] ) -
+                                        previousIn[ stage ][ lane ];
+                        previousIn[ stage ][ lane ] = lanes[ lane ];
+                        previousOut[ stage ][ lane ] = y;
+                        lanes[ lane ] = y;
+                    }
+                }
+                swapChains();
+                
+                sums.add( delayedLeft, lanes[ 1 ], delayedRight, lanes[ 3 ] );
+                delayedLeft = lanes[ 0 ];
+                delayedRight = lanes[ 2 ];
+            }
+            
+            // silence => no phase information
+            result.histogram = sums.histogram;
+            if ( sums.envelope < 1.0e-9f ) {
+                result.coherence = 0.f;
+                return;
+            }
+            
+            result.coherence = juce::jlimit( -1.f, 1.f, sums.dot / sums.envelope );
+            for ( auto& weight : result.histogram )
+                weight /= sums.envelope;
+        }
+        
+    private:
+        struct Sums {
+            void add( float realLeft, float imaginaryLeft, float realRight, float imaginaryRight ) {
+                // the imaginary chain leads the real one by 90 degrees, so these are
+                // the conjugates of the analytic signals, and the angle of L conj( R )
+                // is phase right - phase left: dot = |L| |R| cos, cross = |L| |R| sin
+                const float sampleDot = realLeft * realRight + imaginaryLeft * imaginaryRight;
+                const float cross = imaginaryLeft * realRight - realLeft * imaginaryRight;
+                const float weight = std::sqrt( sampleDot * sampleDot + cross * cross );
+                
+                dot += sampleDot;
+                envelope += weight;
+                histogram[ findBin( cross, sampleDot ) ] += weight;
+            }
+            
+            float dot = 0.f, envelope = 0.f;
+            std::array< float, numHistogramBins > histogram{};
+        };
+        
+        static size_t findBin( float y, float x ) {
+        /* bin of atan2( y, x ); the 22.5 degree bin edges are found by comparison, without the angle */
+            static_assert( numHistogramBins == 16, "bin edges are multiples of 22.5 degrees" );
+            constexpr float tan22_5 = 0.41421356f;
+            
+            // 0 to 3 within the first quadrant, then mirrored into the others
+            const float absX = std::abs( x ), absY = std::abs( y );
+            int bin = absY <= absX ? ( absY > tan22_5 * absX ? 1 : 0 )
+                                   : ( absX > tan22_5 * absY ? 2 : 3 );
+            if ( x < 0.f )
+                bin = 7 - bin;
+            
+            return static_cast< size_t >( y < 0.f ? 7 - bin : 8 + bin );
+        }
+        
+        void swapChains() {
+            for ( int stage = 0; stage < numStages; stage++ ) {
+                std::swap_ranges( previousIn[ stage ], previousIn[ stage ] + chainLanes,
+                                  previousIn[ stage ] + chainLanes );
+                std::swap_ranges( previousOut[ stage ], previousOut[ stage ] + chainLanes,
+                                  previousOut[ stage ] + chainLanes );
+            }
+        }
+        
+        using Vector = juce::dsp::SIMDRegister< float >;
+        
+        static constexpr int numStages = 4;
+        static constexpr int chainLanes = 4;
+        static constexpr int numLanes = 2 * chainLanes;
+        static constexpr int vectorSize = static_cast< int >( Vector::size() );
+        static constexpr int numVectors = numLanes / vectorSize;
+        static_assert( numLanes % vectorSize == 0, "lanes must fill whole registers" );
+        
+        // per stage, the input and output of the same chain two samples back;
+        // aligned for loading into registers of up to 256 bits
+        alignas( 32 ) float coefficients[ numStages ][ numLanes ] = {};
+        alignas( 32 ) float previousIn[ numStages ][ numLanes ] = {};
+        alignas( 32 ) float previousOut[ numStages ][ numLanes ] = {};
+        float delayedLeft = 0.f, delayedRight = 0.f;
+    };
+}
@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+    LockFreeFifo.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+Wait-free single-producer, single-consumer queue of trivially copyable items,
+used to hand data from the audio thread to other threads without locking.
+Holds at most capacity - 1 items; push() fails instead of blocking when full.
+*/
+template < typename Item, int capacity >
+class LockFreeFifo {
+public:
+    bool push( const Item& item ) {
+        const auto scope = fifo.write( 1 );
+        
+        if ( scope.blockSize1 == 0 )
+            return false;
+        
+        items[ scope.startIndex1 ] = item;
+        return true;
+    }
+    
+    bool pop( Item& item ) {
+        const auto scope = fifo.read( 1 );
+        
+        if ( scope.blockSize1 == 0 )
+            return false;
+        
+        item = items[ scope.startIndex1 ];
+        return true;
+    }
+    
+    int getNumReady() const { return fifo.getNumReady(); }
+    
+private:
+    juce::AbstractFifo fifo{ capacity };
+    std::array< Item, capacity > items{};
+};
@@ -0,0 +1,39 @@
+/*
+  ==============================================================================
+
+    MeterSnapshot.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+Values measured by one processBlock call, published from the audio thread
+to the background analysis and display code.
+*/
+struct MeterSnapshot {
+    float correlationIn = 0.f;
+    float correlationOut = 0.f;
+    
+    // -2.0 => sentinel value, as in the processor
+    float minCorrelationIn = -2.f;
+    float minCorrelationOut = -2.f;
+    
+    float rmsLeft = -100.f;
+    float rmsRight = -100.f;
+    
+    // envelope-weighted mean cosine of the instantaneous phase difference
+    float phaseCoherence = 0.f;
+    
+    int numSamples = 0;
+    
+    // playhead position of the block's first sample, -1 if the host has none
+    juce::int64 timelinePosition = -1;
+    bool isPlaying = false;
+    
+    // to estimate when the block becomes audible
+    double processedAtMs = 0.0;
+};
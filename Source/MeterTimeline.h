@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    MeterTimeline.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "MeterSnapshot.h"
+
+namespace Gui {
+    /*
+    The most recent meter snapshots, kept so that the editor can present the one
+    that is being heard rather than the one that was just processed. Blocks are
+    processed ahead of playback by roughly their own length plus the output
+    latency after the plugin. At smaller blocks or higher rates than the ring is
+    sized for, the oldest kept snapshot is shown.
+    */
+    class MeterTimeline {
+    public:
+        void add( const MeterSnapshot& snapshot ) {
+            snapshots[ next ] = snapshot;
+            next = ( next + 1 ) % capacity;
+            size = juce::jmin( size + 1, capacity );
+        }
+        
+        const MeterSnapshot* findAudible( double nowMs, double sampleRate,
+                                          int outputLatencySamples ) const {
+        /* snapshot at the estimated audible position, or nullptr if empty */
+            if ( size == 0 )
+                return nullptr;
+            
+            const auto& newest = snapshots[ ( next - 1 + capacity ) % capacity ];
+            
+            // nothing to line up with when stopped or without a timeline
+            if ( ! newest.isPlaying || newest.timelinePosition < 0 )
+                return &newest;
+            
+            const double audiblePosition =
+                newest.timelinePosition +
+                ( nowMs - newest.processedAtMs ) * 0.001 * sampleRate -
+                ( newest.numSamples + outputLatencySamples );
+            
+            // walk back until reaching the audible block, stopping at loops and jumps
+            const MeterSnapshot* result = &newest;
+            auto previousPosition = newest.timelinePosition;
+            for ( int i = 0; i < size; i++ ) {
+                const auto& snapshot = snapshots[ ( next - 1 - i + 2 * capacity ) % capacity ];
+                
+                if ( snapshot.timelinePosition < 0 ||
+                     snapshot.timelinePosition > previousPosition )
+                    break;
+                
+                result = &snapshot;
+                if ( snapshot.timelinePosition <= audiblePosition )
+                    break;
+                
+                previousPosition = snapshot.timelinePosition;
+            }
+            
+            return result;
+        }
+        
+    private:
+        // enough to look back past the largest "Display Offset" (500 ms) plus the
+        // device latency and a few blocks, at 32-sample blocks and 192 kHz
+        static constexpr double maxLookBackSeconds = 0.75;
+        static constexpr int smallestBlockSize = 32;
+        static constexpr int capacity =
+            static_cast< int >( maxLookBackSeconds * 192000.0 ) / smallestBlockSize;
+        
+        std::vector< MeterSnapshot > snapshots = std::vector< MeterSnapshot >( capacity );
+        int next = 0;
+        int size = 0;
+    };
+}
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    PhaseDipDetector.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/* one excursion of the correlation below the dip threshold */
+struct PhaseDipEvent {
+    // in samples, on the host timeline when it has one
+    juce::int64 start = 0;
+    juce::int64 length = 0;
+    
+    float worstCorrelation = 0.f;
+};
+
+namespace Dsp {
+    /*
+    Tracks excursions below a correlation threshold with constant state per
+    block, reporting each one once it has ended.
+    */
+    class PhaseDipDetector {
+    public:
+        void reset() { inDip = false; }
+        
+        bool finish( PhaseDipEvent& ended ) {
+        /* ends a dip that is still open, e.g. when playback stops */
+            if ( ! inDip )
+                return false;
+            
+            ended = current;
+            inDip = false;
+            return true;
+        }
+        
+        bool process( float correlation, float threshold, juce::int64 position,
+                      int numSamples, PhaseDipEvent& ended ) {
+        /* returns true and fills ended when a dip finished with this block */
+            bool hasEnded = false;
+            
+            // a jump on the timeline ends the current dip
+            if ( inDip && position != current.start + current.length ) {
+                ended = current;
+                hasEnded = true;
+                inDip = false;
+            }
+            
+            if ( correlation < threshold ) {
+                if ( ! inDip ) {
+                    inDip = true;
+                    current.start = position;
+                    current.length = 0;
+                    current.worstCorrelation = correlation;
+                }
+                
+                current.length += numSamples;
+                current.worstCorrelation = juce::jmin( current.worstCorrelation, correlation );
+            } else if ( inDip ) {
+                ended = current;
+                hasEnded = true;
+                inDip = false;
+            }
+            
+            return hasEnded;
+        }
+        
+    private:
+        bool inDip = false;
+        PhaseDipEvent current;
+    };
+}
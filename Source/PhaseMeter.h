@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    PhaseMeter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "GuiResources.h"
+#include "HilbertAnalyser.h"
+
+namespace Gui {
+    /*
+    Fast readout of the instantaneous phase difference: the envelope-weighted
+    coherence as a number and the distribution of the difference as bars, from
+    -180 degrees on the left through 0 in the middle to 180 on the right.
+    */
+    class PhaseMeter : public juce::Component {
+    
+    public:
+        using Histogram = std::array< float, Dsp::HilbertAnalyser::numHistogramBins >;
+        
+        void paint( juce::Graphics& g ) override {
+            using namespace juce;
+            
+            const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+            if ( background.isNull() || backgroundScale != scale ) {
+                background = resources->getImage( "PhaseMeter", getWidth(), getHeight(), scale,
+                                                  [ this ]( Graphics& bg ) { paintBackground( bg ); } );
+                backgroundScale = scale;
+            }
+            g.drawImage( background, getLocalBounds().toFloat() );
+            
+            const auto layout = getLayout( g.getCurrentFont() );
+            const auto& titleBar = layout.titleBar;
+            const auto& display = layout.display;
+            int textHeight = g.getCurrentFont().getHeight();
+            
+            g.setColour( Colours::white.withBrightness( 0.5f ) );
+            String coherenceStr( "Coherence: " );
+            coherenceStr << String( coherence, 2, false );
+            g.drawFittedText( coherenceStr,
+                              titleBar.getX(),
+                              titleBar.getY(),
+                              titleBar.getWidth() * 0.93,
+                              textHeight,
+                              Justification::centredRight,
+                              1 );
+            
+            // bars relative to the fullest bin, so the shape stays readable at any level
+            float fullest = 0.f;
+            for ( auto weight : histogram )
+                fullest = jmax( fullest, weight );
+            if ( fullest <= 0.f )
+                return;
+            
+            const int numBins = static_cast< int >( histogram.size() );
+            const float binWidth = display.getWidth() / numBins;
+            for ( int bin = 0; bin < numBins; bin++ ) {
+                // out of phase by more than 90 degrees => same shade of red as the minimum marker
+                const bool outOfPhase = bin < numBins / 4 || bin >= numBins * 3 / 4;
+                g.setColour( outOfPhase ? Colour( 209, 63, 63 ) : Colours::white );
+                
+                const float height = display.getHeight() * histogram[ static_cast< size_t >( bin ) ] / fullest;
+                g.fillRect( display.getX() + bin * binWidth + 1,
+                            display.getBottom() - height,
+                            binWidth - 2,
+                            height );
+            }
+        }
+        
+        void resized() override {
+            background = {};
+        }
+        
+        void setCoherence( const float value ) { coherence = value; }
+        void setHistogram( const Histogram& value ) { histogram = value; }
+        
+    private:
+        struct Layout {
+            juce::Rectangle< float > titleBar, display;
+        };
+        
+        Layout getLayout( const juce::Font& font ) const {
+            auto bounds = getLocalBounds().toFloat();
+            
+            Layout layout;
+            layout.titleBar = bounds.removeFromTop( font.getHeight() * 1.25f );
+            layout.display = bounds.reduced( bounds.getWidth() * 0.1, bounds.getHeight() * 0.15 );
+            return layout;
+        }
+        
+        void paintBackground( juce::Graphics& g ) const {
+        /* title and frame of the histogram */
+            using namespace juce;
+            
+            const auto layout = getLayout( g.getCurrentFont() );
+            const auto& titleBar = layout.titleBar;
+            const auto& display = layout.display;
+            int textHeight = g.getCurrentFont().getHeight();
+            
+            g.setColour( Colours::white.withBrightness( 0.5f ) );
+            g.drawFittedText( title,
+                              titleBar.getX() + titleBar.getWidth() * 0.07,
+                              titleBar.getY(),
+                              g.getCurrentFont().getStringWidth( title ),
+                              textHeight,
+                              Justification::centred,
+                              1 );
+            
+            g.setColour( Colours::white.withBrightness( 0.3f ) );
+            g.fillRoundedRectangle( display, 3.f );
+            
+            // mark 0 degrees
+            g.setColour( Colours::white.withBrightness( 0.7f ) );
+            g.fillRoundedRectangle(
+                display.getX() + display.getWidth() * 0.5 - 1,
+                display.getY(),
+                2,
+                display.getHeight(),
+                0.5f );
+        }
+        
+        const juce::String title{ "Phase difference:" };
+        
+        float coherence = 0.f;
+        Histogram histogram{};
+        
+        juce::SharedResourcePointer< GuiResources > resources;
+        juce::Image background;
+        float backgroundScale = 0.f;
+    };
+}
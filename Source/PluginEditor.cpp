@@ -9,6 +9,10 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+#if JucePlugin_Build_Standalone
+ #include <juce_audio_plugin_client/Standalone/juce_StandaloneFilterWindow.h>
+#endif
+
 void LookAndFeel::drawToggleButton( juce::Graphics &g,
                                     juce::ToggleButton &toggleButton,
                                     bool shouldDrawToggleButtonAsHighlighted,
@@ -33,18 +37,19 @@ SimpleCorrelationMeterAudioProcessorEditor::SimpleCorrelationMeterAudioProcessor
     : AudioProcessorEditor (&p), audioProcessor (p),
     correlationIn( "Correlation in:" ),
     correlationOut( "Correlation out:" ),
-    verticalGradientMeterL( [ & ]() { return audioProcessor.getRmsValue( 0 ); },
-                            true ),
-    verticalGradientMeterR( [ & ]() { return audioProcessor.getRmsValue( 1 ); },
-                            false ),
+    verticalGradientMeterL( [ & ]() { return presented.rmsLeft; }, true ),
+    verticalGradientMeterR( [ & ]() { return presented.rmsRight; }, false ),
     valueTreeState(vts)
 {
+    displayOffset = valueTreeState.getRawParameterValue( "Display Offset" );
+    
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
     addAndMakeVisible( correlationIn );
     addAndMakeVisible( correlationOut );
     addAndMakeVisible( verticalGradientMeterL );
     addAndMakeVisible( verticalGradientMeterR );
+    addAndMakeVisible( phaseMeter );
     
     invertLeftButton.setButtonText( "Invert Left" );
     addAndMakeVisible( invertLeftButton );
@@ -58,15 +63,19 @@ SimpleCorrelationMeterAudioProcessorEditor::SimpleCorrelationMeterAudioProcessor
                                                        "Invert Right",
                                                        invertRightButton ) );
 
-    invertLeftButton.setLookAndFeel( &lnf );
-    invertRightButton.setLookAndFeel( &lnf );
+    invertLeftButton.setLookAndFeel( &lnf.get() );
+    invertRightButton.setLookAndFeel( &lnf.get() );
      
     setSize (400, 600);
     startTimerHz( 24 );
+    
+    audioProcessor.setEditorVisible( true );
 }
 
 SimpleCorrelationMeterAudioProcessorEditor::~SimpleCorrelationMeterAudioProcessorEditor()
 {
+    audioProcessor.setEditorVisible( false );
+    
     invertLeftButton.setLookAndFeel( nullptr );
     invertRightButton.setLookAndFeel( nullptr );
 }
@@ -118,17 +127,52 @@ void SimpleCorrelationMeterAudioProcessorEditor::resized()
     
     auto correlationOutArea = bounds.removeFromTop( getHeight() * 0.2f );
     correlationOut.setBounds( correlationOutArea );
+    
+    phaseMeter.setBounds( bounds );
 }
 
 void SimpleCorrelationMeterAudioProcessorEditor::timerCallback() {
+    
+    MeterSnapshot snapshot;
+    while ( audioProcessor.popDisplaySnapshot( snapshot ) )
+        timeline.add( snapshot );
+    
+    if ( auto* audible = timeline.findAudible( juce::Time::getMillisecondCounterHiRes(),
+                                               audioProcessor.getSampleRate(),
+                                               getOutputLatencySamples() ) )
+        presented = *audible;
 
-    correlationIn.setCoefficient( audioProcessor.getCorrelationIn() );
-    correlationIn.setMinimumCorrelation( audioProcessor.getMinCorrelationIn() );
+    correlationIn.setCoefficient( presented.correlationIn );
+    correlationIn.setMinimumCorrelation( presented.minCorrelationIn );
+    correlationIn.setLongTermCorrelation( audioProcessor.getLongTermCorrelationIn() );
         
-    correlationOut.setCoefficient( audioProcessor.getCorrelationOut() );
-    correlationOut.setMinimumCorrelation( audioProcessor.getMinCorrelationOut() );
+    correlationOut.setCoefficient( presented.correlationOut );
+    correlationOut.setMinimumCorrelation( presented.minCorrelationOut );
+    correlationOut.setLongTermCorrelation( audioProcessor.getLongTermCorrelationOut() );
+    
+    // the histogram is already smoothed, so it is shown as it arrives
+    Gui::PhaseMeter::Histogram histogram;
+    audioProcessor.getPhaseHistogram( histogram );
+    phaseMeter.setHistogram( histogram );
+    phaseMeter.setCoherence( presented.phaseCoherence );
     
     correlationIn.repaint();
     correlationOut.repaint();
+    phaseMeter.repaint();
+}
+
+int SimpleCorrelationMeterAudioProcessorEditor::getOutputLatencySamples() const {
+    // a plugin can't ask the host for its output latency, so that is set by hand
+    // with "Display Offset"; only the standalone app knows its audio device
+    int latency = juce::roundToInt( *displayOffset * 0.001 * audioProcessor.getSampleRate() );
+    
+   #if JucePlugin_Build_Standalone
+    if ( audioProcessor.wrapperType == juce::AudioProcessor::wrapperType_Standalone )
+        if ( auto* holder = juce::StandalonePluginHolder::getInstance() )
+            if ( auto* device = holder->deviceManager.getCurrentAudioDevice() )
+                latency += device->getOutputLatencyInSamples();
+   #endif
+    
+    return latency;
 }
 //==============================================================================
@@ -11,6 +11,8 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "CorrelationMeter.h"
+#include "MeterTimeline.h"
+#include "PhaseMeter.h"
 #include "VerticalGradientMeter.h"
 
 //==============================================================================
@@ -40,6 +42,8 @@ public:
 
 private:
     typedef juce::AudioProcessorValueTreeState::ButtonAttachment ButtonAttachment;
+    
+    int getOutputLatencySamples() const;
 
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
@@ -49,13 +53,21 @@ private:
 
     Gui::VerticalGradientMeter verticalGradientMeterL, verticalGradientMeterR;
     
+    Gui::PhaseMeter phaseMeter;
+    
     juce::AudioProcessorValueTreeState& valueTreeState;
     juce::ToggleButton invertLeftButton;
     std::unique_ptr< ButtonAttachment > invertLeftAttachment;
     juce::ToggleButton invertRightButton;
     std::unique_ptr< ButtonAttachment > invertRightAttachment;
     
-    LookAndFeel lnf;
+    // shared by all open editors
+    juce::SharedResourcePointer< LookAndFeel > lnf;
+    
+    // meter values are presented when they are heard, not when processed
+    Gui::MeterTimeline timeline;
+    MeterSnapshot presented;
+    std::atomic< float >* displayOffset = nullptr;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleCorrelationMeterAudioProcessorEditor)
 };
@@ -11,6 +11,16 @@
 
 const float CORRELATION_RAMP = 0.15f;
 
+// time constant of the displayed phase difference histogram
+const double PHASE_HISTOGRAM_DECAY = 0.05;
+
+// window of the long-term correlation average, and the step it slides by
+const double HISTORY_SECONDS = 30.0;
+const double HISTORY_BIN_SECONDS = 1.0;
+
+const AnalysisProfile REALTIME_PROFILE{ true, false };
+const AnalysisProfile OFFLINE_PROFILE{ false, true };
+
 //==============================================================================
 SimpleCorrelationMeterAudioProcessor::SimpleCorrelationMeterAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -27,14 +37,39 @@ parameters( *this, nullptr, juce::Identifier( "SimpleCorrelationMeter" ),
             { std::make_unique< juce::AudioParameterBool >(
                 juce::ParameterID{ "Invert Left", 1 }, "Invert Left", false ),
               std::make_unique< juce::AudioParameterBool >(
-                juce::ParameterID{ "Invert Right", 1 }, "Invert Right", false ) } )
+                juce::ParameterID{ "Invert Right", 1 }, "Invert Right", false ),
+              std::make_unique< juce::AudioParameterBool >(
+                juce::ParameterID{ "Decimated Analysis", 1 }, "Decimated Analysis", false ),
+              std::make_unique< juce::AudioParameterFloat >(
+                juce::ParameterID{ "Dip Threshold", 1 }, "Dip Threshold",
+                juce::NormalisableRange< float >( -1.f, 1.f, 0.01f ), 0.f ),
+              std::make_unique< juce::AudioParameterBool >(
+                juce::ParameterID{ "Log Phase Dips", 1 }, "Log Phase Dips", false ),
+              std::make_unique< juce::AudioParameterFloat >(
+                juce::ParameterID{ "Display Offset", 1 }, "Display Offset",
+                juce::NormalisableRange< float >( 0.f, 500.f, 1.f ), 0.f,
+                juce::AudioParameterFloatAttributes().withLabel( "ms" ) ) } )
 {
     invertLeft = parameters.getRawParameterValue( "Invert Left" );
     invertRight = parameters.getRawParameterValue( "Invert Right" );
+    decimatedAnalysis = parameters.getRawParameterValue( "Decimated Analysis" );
+    dipThreshold = parameters.getRawParameterValue( "Dip Threshold" );
+    logPhaseDips = parameters.getRawParameterValue( "Log Phase Dips" );
+    
+    // past AnalysisScheduler::maxClients instances, there is no long-term
+    // average or dip log, and nothing waits for a worker that never comes
+    analysisScheduled = scheduler->registerClient( *this );
+    jassert( analysisScheduled );
+    telemetry->addChannel( telemetryChannel );
 }
 
 SimpleCorrelationMeterAudioProcessor::~SimpleCorrelationMeterAudioProcessor()
 {
+    // the queued job still runs before unregisterClient() returns
+    finishPhaseDip( true );
+    
+    telemetry->removeChannel( telemetryChannel );
+    scheduler->unregisterClient( *this );
 }
 
 //==============================================================================
@@ -114,12 +149,30 @@ void SimpleCorrelationMeterAudioProcessor::prepareToPlay (double sampleRate, int
     rmsLevelLeft.setCurrentAndTargetValue( -100.f );
     rmsLevelRight.setCurrentAndTargetValue( -100.f );
     correlationIn.setCurrentAndTargetValue( 0.f );
+    
+    // allocate the decimated analysis path up front so toggling it is free
+    maximumBlockSize = samplesPerBlock;
+    decimator.prepare( sampleRate, samplesPerBlock, 2 );
+    analysisBuffer.setSize( 2, decimator.getMaximumOutputSize() );
+    previouslyDecimated = false;
+    
+    hilbert.reset();
+    for ( auto& weight : phaseHistogram )
+        weight = 0.f;
+    
+    finishPhaseDip( true );
+    dipDetector.reset();
+    processedSamples = 0;
+    
+    binIn.reset();
+    binOut.reset();
 }
 
 void SimpleCorrelationMeterAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    finishPhaseDip( true );
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -148,36 +201,18 @@ bool SimpleCorrelationMeterAudioProcessor::isBusesLayoutSupported (const BusesLa
 }
 #endif
 
-static float computeCorrelation( const float* x, const float* y, int numSamples ) {
-    // get mean for left and right channels
-    float meanX = 0.f, meanY = 0.f;
-    for ( int i = 0; i < numSamples; i++ ){
-        meanX += x[ i ];
-        meanY = y[ i ];
-    }
-    meanX /= numSamples;
-    meanY /= numSamples;
-    
-    // calculate Pearson correlation coefficient
-    float numerator = 0.f, leftSumSquared = 0.f, rightSumSquared = 0.f;
-    float leftDiff = 0.f, rightDiff = 0.f;
-    for ( int i = 0; i < numSamples; i++ ){
-        leftDiff = x[ i ] - meanX;
-        rightDiff = y[ i ] - meanY;
-        
-        numerator += leftDiff * rightDiff;
-        leftSumSquared += leftDiff * leftDiff;
-        rightSumSquared += rightDiff * rightDiff;
-    }
-    float correlation = numerator / std::sqrt( leftSumSquared * rightSumSquared );
-    
-    // if correlation within range
-    if ( correlation >= -1.f && correlation <= 1.f ) {
-        return correlation;
-    }
+static float computeRms( const float* x, int numSamples ) {
+    double sum = 0.0;
+    for ( int i = 0; i < numSamples; i++ )
+        sum += x[ i ] * x[ i ];
     
-    // NaN guard
-    return 0.f;
+    return static_cast< float >( std::sqrt( sum / numSamples ) );
+}
+
+template < typename Accumulator >
+static float computeCorrelation( const float* x, const float* y, int numSamples ) {
+    return Dsp::CorrelationStatistics< Accumulator >::fromSamples( x, y, numSamples )
+        .getCorrelation();
 }
 
 /*
@@ -206,28 +241,75 @@ void SimpleCorrelationMeterAudioProcessor::processBlock (juce::AudioBuffer<float
     correlationIn.skip( bufferSize );
     correlationOut.skip( bufferSize );
     
-    {
-        const auto value = Decibels::gainToDecibels(
-            buffer.getRMSLevel( 0, 0, bufferSize ) );
-        if ( value < rmsLevelLeft.getCurrentValue() )
-            rmsLevelLeft.setTargetValue( value );
-        else
-            rmsLevelLeft.setCurrentAndTargetValue( value );
-    }
-
-    {
-        const auto value = Decibels::gainToDecibels(
-            buffer.getRMSLevel( 1, 0, bufferSize ) );
-        if ( value < rmsLevelRight.getCurrentValue() )
-            rmsLevelRight.setTargetValue( value );
-        else
-            rmsLevelRight.setCurrentAndTargetValue( value );
+    // switches without reallocating: both profiles run on the buffers set up in prepareToPlay
+    const bool offline = isNonRealtime();
+    const auto& profile = offline ? OFFLINE_PROFILE : REALTIME_PROFILE;
+    
+    // the measurement stages read from here: either the full-rate input or its
+    // decimated copy; passthrough and polarity inversion always stay at full rate
+    const float* analysisLeft = buffer.getReadPointer( 0 );
+    const float* analysisRight = buffer.getReadPointer( 1 );
+    int analysisSize = bufferSize;
+    
+    const bool decimate = profile.allowDecimation &&
+                          ( *decimatedAnalysis > 0.5f ) &&
+                          ( decimator.getFactor() > 1 );
+    if ( decimate ) {
+        if ( ! previouslyDecimated )
+            decimator.reset();
+        
+        // hosts may exceed the announced block size; analyse the most recent part
+        const int analysedSamples = jmin( bufferSize, maximumBlockSize );
+        const float* input[] = { buffer.getReadPointer( 0, bufferSize - analysedSamples ),
+                                 buffer.getReadPointer( 1, bufferSize - analysedSamples ) };
+        
+        analysisSize = decimator.process( input, analysedSamples,
+                                          analysisBuffer.getArrayOfWritePointers() );
+        analysisLeft = analysisBuffer.getReadPointer( 0 );
+        analysisRight = analysisBuffer.getReadPointer( 1 );
     }
     
-    // calculate correlation
-    correlationIn.setTargetValue( computeCorrelation( buffer.getReadPointer( 0 ),
-                                    buffer.getReadPointer( 1 ),
-                                    bufferSize ) );
+    // the Hilbert filters' state belongs to the other rate
+    if ( decimate != previouslyDecimated )
+        hilbert.reset();
+    previouslyDecimated = decimate;
+    
+    // tiny blocks may not complete a single decimated sample
+    if ( analysisSize > 0 ) {
+        {
+            const auto value = Decibels::gainToDecibels(
+                computeRms( analysisLeft, analysisSize ) );
+            if ( value < rmsLevelLeft.getCurrentValue() )
+                rmsLevelLeft.setTargetValue( value );
+            else
+                rmsLevelLeft.setCurrentAndTargetValue( value );
+        }
+        
+        {
+            const auto value = Decibels::gainToDecibels(
+                computeRms( analysisRight, analysisSize ) );
+            if ( value < rmsLevelRight.getCurrentValue() )
+                rmsLevelRight.setTargetValue( value );
+            else
+                rmsLevelRight.setCurrentAndTargetValue( value );
+        }
+        
+        // calculate correlation
+        correlationIn.setTargetValue(
+            profile.doublePrecision ?
+                computeCorrelation< double >( analysisLeft, analysisRight, analysisSize ) :
+                computeCorrelation< float >( analysisLeft, analysisRight, analysisSize ) );
+        
+        // instantaneous phase difference; the histogram is smoothed for display
+        hilbert.process( analysisLeft, analysisRight, analysisSize, phaseResult );
+        
+        const auto decay = static_cast< float >(
+            std::exp( -bufferSize / ( PHASE_HISTOGRAM_DECAY * getSampleRate() ) ) );
+        for ( size_t bin = 0; bin < phaseHistogram.size(); bin++ )
+            phaseHistogram[ bin ].store( decay * phaseHistogram[ bin ].load( std::memory_order_relaxed ) +
+                                             ( 1.f - decay ) * phaseResult.histogram[ bin ],
+                                         std::memory_order_relaxed );
+    }
     
     float currentCorrelationIn = correlationIn.getCurrentValue();
     if ( currentCorrelationIn < 0 ) {
@@ -305,6 +387,10 @@ void SimpleCorrelationMeterAudioProcessor::processBlock (juce::AudioBuffer<float
     }
     
     // reset displayed min correlation when transitioning from paused to playing
+    bool playbackStarted = false;
+    bool playbackStopped = false;
+    juce::int64 timelinePosition = -1;
+    bool isPlaying = false;
     auto playhead = getPlayHead();
 	if ( playhead != nullptr )
 	{
@@ -315,9 +401,16 @@ void SimpleCorrelationMeterAudioProcessor::processBlock (juce::AudioBuffer<float
                 // reset to sentinel value
                 minCorrelationIn = -2.f;
                 minCorrelationOut = -2.f;
+                playbackStarted = true;
             }
             
+            playbackStopped = previouslyPlaying && ! info.getIsPlaying();
+            
             previouslyPlaying = info.getIsPlaying();
+            
+            // stamp the published values with the block's timeline position
+            timelinePosition = info.getTimeInSamples().orFallback( -1 );
+            isPlaying = info.getIsPlaying();
         }
 	}
     
@@ -325,6 +418,177 @@ void SimpleCorrelationMeterAudioProcessor::processBlock (juce::AudioBuffer<float
     if ( outCorrelationWait ) {
         outCorrelationWait = jmax( outCorrelationWait - bufferSize, 0 );
     }
+    
+    // log excursions of the smoothed (displayed) correlation below the dip
+    // threshold, so one-block dips don't flood the log and the result doesn't
+    // depend on the block size; without a host timeline, positions count the
+    // samples processed since prepareToPlay
+    if ( isPlaying || timelinePosition < 0 ) {
+        PhaseDipEvent dip;
+        if ( dipDetector.process( currentCorrelationIn, *dipThreshold,
+                                  timelinePosition < 0 ? processedSamples : timelinePosition,
+                                  bufferSize, dip ) &&
+             *logPhaseDips > 0.5f ) {
+            pushPhaseDip( dip, offline );
+        }
+    }
+    
+    // a dip that lasts until the transport stops ends there
+    if ( playbackStopped )
+        finishPhaseDip( offline );
+    
+    processedSamples += bufferSize;
+    
+    // a render and live playback are separate histories
+    if ( playbackStarted || offline != historyHighAccuracy ) {
+        binIn.reset();
+        binOut.reset();
+        historyHighAccuracy = offline;
+        
+        HistoryUpdate update;
+        update.restart = true;
+        pushHistoryUpdate( update, offline );
+    }
+    
+    const int binLength = roundToInt( getSampleRate() * HISTORY_BIN_SECONDS );
+    binIn.add( correlationIn.getCurrentValue(), bufferSize, binLength );
+    if ( binOut.add( correlationOut.getCurrentValue(), bufferSize, binLength ) ) {
+        HistoryUpdate update;
+        update.hasBin = true;
+        update.correlationIn = binIn.getMean();
+        update.correlationOut = binOut.getMean();
+        pushHistoryUpdate( update, offline );
+        
+        binIn.reset();
+        binOut.reset();
+    }
+    
+    // per-block values for the display and telemetry
+    MeterSnapshot snapshot;
+    snapshot.correlationIn = correlationIn.getCurrentValue();
+    snapshot.correlationOut = correlationOut.getCurrentValue();
+    snapshot.minCorrelationIn = minCorrelationIn;
+    snapshot.minCorrelationOut = minCorrelationOut;
+    snapshot.rmsLeft = rmsLevelLeft.getCurrentValue();
+    snapshot.rmsRight = rmsLevelRight.getCurrentValue();
+    snapshot.phaseCoherence = phaseResult.coherence;
+    snapshot.numSamples = bufferSize;
+    snapshot.timelinePosition = timelinePosition;
+    snapshot.isPlaying = isPlaying;
+    snapshot.processedAtMs = Time::getMillisecondCounterHiRes();
+    
+    // nobody would read these until an editor opens, and by then they'd be stale
+    if ( editorVisible.load( std::memory_order_relaxed ) )
+        displayQueue.push( snapshot );
+    telemetryChannel.push( snapshot );
+}
+
+void SimpleCorrelationMeterAudioProcessor::runAnalysis()
+{
+    HistoryUpdate update;
+    while ( historyQueue.pop( update ) ) {
+        if ( update.restart ) {
+            const int binsToAverage = juce::roundToInt( HISTORY_SECONDS / HISTORY_BIN_SECONDS );
+            historyIn.reset( binsToAverage );
+            historyOut.reset( binsToAverage );
+        }
+        
+        if ( update.hasBin ) {
+            historyIn.add( update.correlationIn );
+            historyOut.add( update.correlationOut );
+        }
+    }
+    
+    longTermCorrelationIn = historyIn.getAverage();
+    longTermCorrelationOut = historyOut.getAverage();
+    
+    PhaseDipEvent dip;
+    while ( dipQueue.pop( dip ) )
+        writePhaseDip( dip );
+}
+
+void SimpleCorrelationMeterAudioProcessor::pushPhaseDip( const PhaseDipEvent& dip, bool canWait )
+{
+    // renders and the message thread can wait for room; live, the dip is
+    // counted and reported with the next one that makes it
+    while ( ! dipQueue.push( dip ) ) {
+        if ( ! canWait || ! analysisScheduled ) {
+            numDroppedDips++;
+            break;
+        }
+        
+        juce::Thread::sleep( 1 );
+    }
+    
+    requestAnalysis();
+}
+
+void SimpleCorrelationMeterAudioProcessor::finishPhaseDip( bool canWait )
+{
+    PhaseDipEvent dip;
+    if ( dipDetector.finish( dip ) && *logPhaseDips > 0.5f )
+        pushPhaseDip( dip, canWait );
+}
+
+void SimpleCorrelationMeterAudioProcessor::pushHistoryUpdate( const HistoryUpdate& update,
+                                                              bool offline )
+{
+    // a render can run far ahead of the workers but has no deadline, so it
+    // waits for room rather than lose a bin; live, one bin a second only
+    // fills the queue if the workers have stalled for a minute
+    while ( ! historyQueue.push( update ) && offline && analysisScheduled )
+        juce::Thread::sleep( 1 );
+    
+    requestAnalysis();
+}
+
+static juce::String formatMarkerTime( juce::int64 samples, double sampleRate ) {
+/* h:mm:ss.mmm, as accepted by DAW region/marker list imports */
+    const auto ms = static_cast< juce::int64 >( samples * 1000.0 / sampleRate );
+    
+    return juce::String( ms / 3600000 ) + ":" +
+           juce::String( ( ms / 60000 ) % 60 ).paddedLeft( '0', 2 ) + ":" +
+           juce::String( ( ms / 1000 ) % 60 ).paddedLeft( '0', 2 ) + "." +
+           juce::String( ms % 1000 ).paddedLeft( '0', 3 );
+}
+
+void SimpleCorrelationMeterAudioProcessor::writePhaseDip( const PhaseDipEvent& dip )
+{
+    // one marker file per instance and session, created with the first dip
+    if ( dipLog == nullptr ) {
+        auto file = juce::File::getSpecialLocation( juce::File::userDocumentsDirectory )
+                        .getChildFile( "SimpleCorrelationMeter" )
+                        .getChildFile( "Phase dips " +
+                                       juce::Time::getCurrentTime().formatted( "%Y-%m-%d %H-%M-%S" ) +
+                                       ".csv" )
+                        .getNonexistentSibling();
+        
+        file.getParentDirectory().createDirectory();
+        dipLog = file.createOutputStream();
+        
+        if ( dipLog == nullptr || dipLog->failedToOpen() ) {
+            dipLog.reset();
+            return;
+        }
+        
+        *dipLog << "#,Name,Start,End,Length\n";
+    }
+    
+    // dips that didn't fit in the queue are noted on the next marker
+    juce::String name = "Phase dip " + juce::String( dip.worstCorrelation, 2 );
+    const int numDropped = numDroppedDips.load();
+    if ( numDropped > numReportedDrops ) {
+        name << " (" << ( numDropped - numReportedDrops ) << " earlier dips dropped)";
+        numReportedDrops = numDropped;
+    }
+    
+    const double sampleRate = getSampleRate();
+    *dipLog << "R" << ++numLoggedDips << ","
+            << name << ","
+            << formatMarkerTime( dip.start, sampleRate ) << ","
+            << formatMarkerTime( dip.start + dip.length, sampleRate ) << ","
+            << formatMarkerTime( dip.length, sampleRate ) << "\n";
+    dipLog->flush();
 }
 
 //==============================================================================
@@ -344,12 +608,17 @@ void SimpleCorrelationMeterAudioProcessor::getStateInformation (juce::MemoryBloc
     // You should use this method to store your parameters in the memory block.
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
+    if ( auto xml = parameters.copyState().createXml() )
+        copyXmlToBinary( *xml, destData );
 }
 
 void SimpleCorrelationMeterAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
+    if ( auto xml = getXmlFromBinary( data, sizeInBytes ) )
+        if ( xml->hasTagName( parameters.state.getType() ) )
+            parameters.replaceState( juce::ValueTree::fromXml( *xml ) );
 }
 
 
@@ -380,6 +649,39 @@ float SimpleCorrelationMeterAudioProcessor::getMinCorrelationOut() const {
     return minCorrelationOut;
 }
 
+float SimpleCorrelationMeterAudioProcessor::getLongTermCorrelationIn() const {
+    return longTermCorrelationIn;
+}
+
+float SimpleCorrelationMeterAudioProcessor::getLongTermCorrelationOut() const {
+    return longTermCorrelationOut;
+}
+
+void SimpleCorrelationMeterAudioProcessor::setEditorVisible( bool isVisible ) {
+    // drop whatever was queued before the previous editor closed
+    if ( isVisible ) {
+        MeterSnapshot snapshot;
+        while ( displayQueue.pop( snapshot ) ) {}
+    }
+    
+    editorVisible = isVisible;
+    setAnalysisVisible( isVisible );
+}
+
+double SimpleCorrelationMeterAudioProcessor::getAnalysisWorkerTimeMs() const {
+    return getWorkerTimeMs();
+}
+
+void SimpleCorrelationMeterAudioProcessor::getPhaseHistogram(
+    std::array< float, Dsp::HilbertAnalyser::numHistogramBins >& histogram ) const {
+    for ( size_t bin = 0; bin < histogram.size(); bin++ )
+        histogram[ bin ] = phaseHistogram[ bin ].load( std::memory_order_relaxed );
+}
+
+bool SimpleCorrelationMeterAudioProcessor::popDisplaySnapshot( MeterSnapshot& snapshot ) {
+    return displayQueue.pop( snapshot );
+}
+
 //==============================================================================
 // This creates new instances of the plugin..
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -9,11 +9,30 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "AnalysisDecimator.h"
+#include "AnalysisScheduler.h"
+#include "CorrelationStatistics.h"
+#include "CorrelationHistory.h"
+#include "HilbertAnalyser.h"
+#include "LockFreeFifo.h"
+#include "MeterSnapshot.h"
+#include "PhaseDipDetector.h"
+#include "TelemetryExporter.h"
+
+/*
+Settings that trade CPU for measurement accuracy. Live playback uses a lean
+profile; offline renders, which have CPU to spare, a high-accuracy one.
+*/
+struct AnalysisProfile {
+    bool allowDecimation;
+    bool doublePrecision;
+};
 
 //==============================================================================
 /**
 */
-class SimpleCorrelationMeterAudioProcessor  : public juce::AudioProcessor
+class SimpleCorrelationMeterAudioProcessor  : public juce::AudioProcessor,
+                                              private AnalysisScheduler::Client
 {
 public:
     //==============================================================================
@@ -61,7 +80,38 @@ public:
     float getMinCorrelationIn() const;
     float getMinCorrelationOut() const;
     
+    // computed on the shared analysis workers; -2.0 until available
+    float getLongTermCorrelationIn() const;
+    float getLongTermCorrelationOut() const;
+    
+    /*
+    background work of instances with an editor on screen goes first, and
+    display snapshots are only queued while one is open
+    */
+    void setEditorVisible( bool isVisible );
+    double getAnalysisWorkerTimeMs() const;
+    
+    /* phase difference distribution, smoothed over the last few blocks */
+    void getPhaseHistogram( std::array< float, Dsp::HilbertAnalyser::numHistogramBins >& histogram ) const;
+    
+    /* timestamped per-block values for the editor's display timeline */
+    bool popDisplaySnapshot( MeterSnapshot& snapshot );
+    
 private:
+    // a completed long-term history bin, or the start of a new history
+    struct HistoryUpdate {
+        bool restart = false;
+        bool hasBin = false;
+        float correlationIn = 0.f;
+        float correlationOut = 0.f;
+    };
+    
+    void runAnalysis() override;
+    void writePhaseDip( const PhaseDipEvent& dip );
+    void pushHistoryUpdate( const HistoryUpdate& update, bool offline );
+    void pushPhaseDip( const PhaseDipEvent& dip, bool canWait );
+    void finishPhaseDip( bool canWait );
+
     juce::LinearSmoothedValue< float >
         rmsLevelLeft, rmsLevelRight, correlationIn, correlationOut;
     
@@ -83,6 +133,55 @@ private:
     bool previouslyInvertedLeft = false;
     bool previouslyInvertedRight = false;
     
+    // optional analysis path at roughly 48 kHz for high sample-rate sessions
+    std::atomic< float >* decimatedAnalysis = nullptr;
+    bool previouslyDecimated = false;
+    
+    Dsp::AnalysisDecimator decimator;
+    juce::AudioBuffer< float > analysisBuffer;
+    int maximumBlockSize = 0;
+    
+    // instantaneous phase difference, cheap enough to run on every block
+    Dsp::HilbertAnalyser hilbert;
+    Dsp::HilbertAnalyser::Result phaseResult;
+    std::array< std::atomic< float >, Dsp::HilbertAnalyser::numHistogramBins > phaseHistogram{};
+    
+    // heavy work runs on the process-wide workers; the audio thread folds every
+    // block into the current history bin and only hands over completed bins,
+    // so the workers can run late without losing audio
+    juce::SharedResourcePointer< AnalysisScheduler > scheduler;
+    bool analysisScheduled = false;
+    Dsp::CorrelationBin binIn, binOut;
+    bool historyHighAccuracy = false;
+    LockFreeFifo< HistoryUpdate, 64 > historyQueue;
+    // one editor timer period of 32-sample blocks at 192 kHz, with room to spare
+    LockFreeFifo< MeterSnapshot, 1024 > displayQueue;
+    std::atomic< bool > editorVisible{ false };
+    
+    // optional export of every block's values for external monitoring
+    juce::SharedResourcePointer< TelemetryExporter > telemetry;
+    TelemetryExporter::Channel telemetryChannel;
+    
+    // only touched by runAnalysis()
+    Dsp::CorrelationHistory historyIn, historyOut;
+    
+    std::atomic< float > longTermCorrelationIn{ -2.f };
+    std::atomic< float > longTermCorrelationOut{ -2.f };
+    
+    // excursions below the dip threshold, written to a marker file in the background
+    std::atomic< float >* dipThreshold = nullptr;
+    std::atomic< float >* logPhaseDips = nullptr;
+    
+    Dsp::PhaseDipDetector dipDetector;
+    juce::int64 processedSamples = 0;
+    LockFreeFifo< PhaseDipEvent, 128 > dipQueue;
+    std::atomic< int > numDroppedDips{ 0 };
+    
+    // only touched by runAnalysis()
+    std::unique_ptr< juce::FileOutputStream > dipLog;
+    int numLoggedDips = 0;
+    int numReportedDrops = 0;
+    
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleCorrelationMeterAudioProcessor)
 };
@@ -0,0 +1,239 @@
+/*
+  ==============================================================================
+
+    RealtimeAudit.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeAudit.h"
+
+#if SIMPLE_CORRELATION_METER_RT_AUDIT
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <poll.h>
+ #include <pthread.h>
+ #include <semaphore.h>
+ #include <time.h>
+ #include <unistd.h>
+#endif
+
+namespace RealtimeAudit {
+    // set while the calling thread is inside a ScopedCallback
+    static thread_local bool inCallback = false;
+    
+    static std::atomic< juce::int64 > numCallbacks{ 0 };
+    static std::atomic< juce::int64 > worstTicks{ 0 };
+    
+    static void check( const char* what ) {
+    /* aborts with a stack trace when called inside a callback */
+        if ( ! inCallback )
+            return;
+        
+        // reporting allocates and writes, so it runs outside of callback mode
+        inCallback = false;
+        std::fprintf( stderr, "Real-time audit: %s inside the audio callback\n%s\n", what,
+                      juce::SystemStats::getStackBacktrace().toRawUTF8() );
+        std::fflush( stderr );
+        std::abort();
+    }
+    
+    ScopedCallback::ScopedCallback() : startTicks( juce::Time::getHighResolutionTicks() ) {
+        jassert( ! inCallback );
+        inCallback = true;
+    }
+    
+    ScopedCallback::~ScopedCallback() {
+        inCallback = false;
+        
+        const auto ticks = juce::Time::getHighResolutionTicks() - startTicks;
+        auto worst = worstTicks.load();
+        while ( ticks > worst && ! worstTicks.compare_exchange_weak( worst, ticks ) ) {}
+        
+        numCallbacks++;
+    }
+    
+    juce::int64 getNumCallbacks() {
+        return numCallbacks;
+    }
+    
+    double getWorstCallbackMs() {
+        return juce::Time::highResolutionTicksToSeconds( worstTicks ) * 1000.0;
+    }
+}
+
+//==============================================================================
+// global allocation functions
+
+static void* allocate( std::size_t size ) {
+    RealtimeAudit::check( "operator new" );
+    return std::malloc( size == 0 ? 1 : size );
+}
+
+static void* allocateAligned( std::size_t size, std::align_val_t alignment ) {
+    RealtimeAudit::check( "operator new" );
+    void* pointer = nullptr;
+    const auto bytes = juce::jmax( static_cast< std::size_t >( alignment ), sizeof( void* ) );
+    return posix_memalign( &pointer, bytes, size == 0 ? 1 : size ) == 0 ? pointer : nullptr;
+}
+
+static void* allocateOrThrow( void* pointer ) {
+    if ( pointer == nullptr )
+        throw std::bad_alloc();
+    
+    return pointer;
+}
+
+static void release( void* pointer ) noexcept {
+    // deleting nullptr is a no-op, not a real-time hazard
+    if ( pointer != nullptr )
+        RealtimeAudit::check( "operator delete" );
+    
+    std::free( pointer );
+}
+
+void* operator new( std::size_t size ) { return allocateOrThrow( allocate( size ) ); }
+void* operator new[]( std::size_t size ) { return allocateOrThrow( allocate( size ) ); }
+void* operator new( std::size_t size, const std::nothrow_t& ) noexcept { return allocate( size ); }
+void* operator new[]( std::size_t size, const std::nothrow_t& ) noexcept { return allocate( size ); }
+
+void* operator new( std::size_t size, std::align_val_t alignment ) {
+    return allocateOrThrow( allocateAligned( size, alignment ) );
+}
+void* operator new[]( std::size_t size, std::align_val_t alignment ) {
+    return allocateOrThrow( allocateAligned( size, alignment ) );
+}
+void* operator new( std::size_t size, std::align_val_t alignment, const std::nothrow_t& ) noexcept {
+    return allocateAligned( size, alignment );
+}
+void* operator new[]( std::size_t size, std::align_val_t alignment, const std::nothrow_t& ) noexcept {
+    return allocateAligned( size, alignment );
+}
+
+void operator delete( void* pointer ) noexcept { release( pointer ); }
+void operator delete[]( void* pointer ) noexcept { release( pointer ); }
+void operator delete( void* pointer, std::size_t ) noexcept { release( pointer ); }
+void operator delete[]( void* pointer, std::size_t ) noexcept { release( pointer ); }
+void operator delete( void* pointer, const std::nothrow_t& ) noexcept { release( pointer ); }
+void operator delete[]( void* pointer, const std::nothrow_t& ) noexcept { release( pointer ); }
+void operator delete( void* pointer, std::align_val_t ) noexcept { release( pointer ); }
+void operator delete[]( void* pointer, std::align_val_t ) noexcept { release( pointer ); }
+void operator delete( void* pointer, std::size_t, std::align_val_t ) noexcept { release( pointer ); }
+void operator delete[]( void* pointer, std::size_t, std::align_val_t ) noexcept { release( pointer ); }
+void operator delete( void* pointer, std::align_val_t, const std::nothrow_t& ) noexcept { release( pointer ); }
+void operator delete[]( void* pointer, std::align_val_t, const std::nothrow_t& ) noexcept { release( pointer ); }
+
+//==============================================================================
+// C library functions, interposed on Linux: the executable's definitions take
+// precedence over libc's for every caller, and forward to libc's
+
+#if JUCE_LINUX
+extern "C" {
+    void* __libc_malloc( size_t );
+    void* __libc_calloc( size_t, size_t );
+    void* __libc_realloc( void*, size_t );
+    void __libc_free( void* );
+}
+
+template < typename Function >
+static Function* findNext( std::atomic< void* >& cached, const char* name ) {
+/* libc's definition of name, resolved on first use */
+    auto* function = cached.load( std::memory_order_relaxed );
+    if ( function == nullptr ) {
+        function = dlsym( RTLD_NEXT, name );
+        cached.store( function, std::memory_order_relaxed );
+    }
+    
+    return reinterpret_cast< Function* >( function );
+}
+
+extern "C" {
+    // dlsym itself allocates, so the allocator forwards to glibc's entry points directly
+    void* malloc( size_t size ) noexcept {
+        RealtimeAudit::check( "malloc" );
+        return __libc_malloc( size );
+    }
+    
+    void* calloc( size_t count, size_t size ) noexcept {
+        RealtimeAudit::check( "calloc" );
+        return __libc_calloc( count, size );
+    }
+    
+    void* realloc( void* pointer, size_t size ) noexcept {
+        RealtimeAudit::check( "realloc" );
+        return __libc_realloc( pointer, size );
+    }
+    
+    void free( void* pointer ) noexcept {
+        if ( pointer != nullptr )
+            RealtimeAudit::check( "free" );
+        
+        __libc_free( pointer );
+    }
+    
+    int pthread_mutex_lock( pthread_mutex_t* mutex ) noexcept {
+        static std::atomic< void* > next{ nullptr };
+        RealtimeAudit::check( "pthread_mutex_lock" );
+        return findNext< int( pthread_mutex_t* ) >( next, "pthread_mutex_lock" )( mutex );
+    }
+    
+    int pthread_cond_wait( pthread_cond_t* condition, pthread_mutex_t* mutex ) {
+        static std::atomic< void* > next{ nullptr };
+        RealtimeAudit::check( "pthread_cond_wait" );
+        return findNext< int( pthread_cond_t*, pthread_mutex_t* ) >( next, "pthread_cond_wait" )(
+            condition, mutex );
+    }
+    
+    int pthread_cond_timedwait( pthread_cond_t* condition, pthread_mutex_t* mutex,
+                                const struct timespec* time ) {
+        static std::atomic< void* > next{ nullptr };
+        RealtimeAudit::check( "pthread_cond_timedwait" );
+        return findNext< int( pthread_cond_t*, pthread_mutex_t*, const struct timespec* ) >(
+            next, "pthread_cond_timedwait" )( condition, mutex, time );
+    }
+    
+    int sem_wait( sem_t* semaphore ) {
+        static std::atomic< void* > next{ nullptr };
+        RealtimeAudit::check( "sem_wait" );
+        return findNext< int( sem_t* ) >( next, "sem_wait" )( semaphore );
+    }
+    
+    int nanosleep( const struct timespec* duration, struct timespec* remaining ) {
+        static std::atomic< void* > next{ nullptr };
+        RealtimeAudit::check( "nanosleep" );
+        return findNext< int( const struct timespec*, struct timespec* ) >( next, "nanosleep" )(
+            duration, remaining );
+    }
+    
+    int usleep( useconds_t duration ) {
+        static std::atomic< void* > next{ nullptr };
+        RealtimeAudit::check( "usleep" );
+        return findNext< int( useconds_t ) >( next, "usleep" )( duration );
+    }
+    
+    ssize_t read( int fd, void* buffer, size_t numBytes ) {
+        static std::atomic< void* > next{ nullptr };
+        RealtimeAudit::check( "read" );
+        return findNext< ssize_t( int, void*, size_t ) >( next, "read" )( fd, buffer, numBytes );
+    }
+    
+    ssize_t write( int fd, const void* buffer, size_t numBytes ) {
+        static std::atomic< void* > next{ nullptr };
+        RealtimeAudit::check( "write" );
+        return findNext< ssize_t( int, const void*, size_t ) >( next, "write" )( fd, buffer, numBytes );
+    }
+    
+    int poll( struct pollfd* fds, nfds_t numFds, int timeoutMs ) {
+        static std::atomic< void* > next{ nullptr };
+        RealtimeAudit::check( "poll" );
+        return findNext< int( struct pollfd*, nfds_t, int ) >( next, "poll" )( fds, numFds, timeoutMs );
+    }
+}
+#endif
+
+#endif
@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    RealtimeAudit.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef SIMPLE_CORRELATION_METER_RT_AUDIT
+ #define SIMPLE_CORRELATION_METER_RT_AUDIT 0
+#endif
+
+/*
+Real-time safety audit for the headless targets, on in their Debug builds.
+Inside a ScopedCallback, any allocation, mutex lock or blocking system call on
+the calling thread aborts the program with a stack trace. Allocation through
+operator new / delete is trapped everywhere; malloc, locks and system calls on
+Linux only. Never compile RealtimeAudit.cpp into the plugin: it replaces the
+global allocation functions of whatever binary it is linked into.
+*/
+namespace RealtimeAudit {
+    constexpr bool enabled = SIMPLE_CORRELATION_METER_RT_AUDIT != 0;
+    
+   #if SIMPLE_CORRELATION_METER_RT_AUDIT
+    /* marks the calling thread as inside an audio callback and times it */
+    class ScopedCallback {
+    public:
+        ScopedCallback();
+        ~ScopedCallback();
+        
+    private:
+        juce::int64 startTicks;
+        
+        JUCE_DECLARE_NON_COPYABLE( ScopedCallback )
+    };
+    
+    juce::int64 getNumCallbacks();
+    double getWorstCallbackMs();
+   #else
+    struct ScopedCallback { ScopedCallback() {} };
+    
+    inline juce::int64 getNumCallbacks() { return 0; }
+    inline double getWorstCallbackMs() { return 0.0; }
+   #endif
+}
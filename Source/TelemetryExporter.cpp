@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    TelemetryExporter.cpp
+
+  ==============================================================================
+*/
+
+#include "TelemetryExporter.h"
+
+// how often pending snapshots are collected and sent
+const int SEND_INTERVAL_MS = 50;
+
+static juce::uint8* writeUint32( juce::uint8* dest, juce::uint32 value ) {
+    value = juce::ByteOrder::swapIfBigEndian( value );
+    std::memcpy( dest, &value, sizeof( value ) );
+    return dest + sizeof( value );
+}
+
+static juce::uint8* writeInt64( juce::uint8* dest, juce::int64 value ) {
+    auto bits = juce::ByteOrder::swapIfBigEndian( static_cast< juce::uint64 >( value ) );
+    std::memcpy( dest, &bits, sizeof( bits ) );
+    return dest + sizeof( bits );
+}
+
+static juce::uint8* writeFloat( juce::uint8* dest, float value ) {
+    juce::uint32 bits;
+    std::memcpy( &bits, &value, sizeof( bits ) );
+    return writeUint32( dest, bits );
+}
+
+TelemetryExporter::TelemetryExporter() : juce::Thread( "Correlation telemetry" ) {
+    port = juce::SystemStats::getEnvironmentVariable(
+        "SIMPLE_CORRELATION_METER_TELEMETRY_PORT", {} ).getIntValue();
+    
+    if ( port < 0 || port > 65535 )
+        port = 0;
+    
+    if ( isEnabled() )
+        startThread( juce::Thread::Priority::low );
+}
+
+TelemetryExporter::~TelemetryExporter() {
+    stopThread( 1000 );
+}
+
+void TelemetryExporter::addChannel( Channel& channel ) {
+    if ( ! isEnabled() )
+        return;
+    
+    if ( channel.queue == nullptr )
+        channel.queue = std::make_unique< LockFreeFifo< MeterSnapshot, 1024 > >();
+    
+    const juce::ScopedLock sl( channelsLock );
+    channel.instanceId = nextInstanceId++;
+    channel.active.store( true, std::memory_order_release );
+    channels.addIfNotAlreadyThere( &channel );
+}
+
+void TelemetryExporter::removeChannel( Channel& channel ) {
+    // waits for a send pass in progress, which may be reading this channel
+    const juce::ScopedLock sl( channelsLock );
+    channel.active = false;
+    channels.removeFirstMatchingValue( &channel );
+}
+
+void TelemetryExporter::run() {
+    while ( ! threadShouldExit() ) {
+        {
+            const juce::ScopedLock sl( channelsLock );
+            
+            for ( auto* channel : channels )
+                drain( *channel );
+        }
+        
+        flush();
+        wait( SEND_INTERVAL_MS );
+    }
+}
+
+void TelemetryExporter::drain( Channel& channel ) {
+    MeterSnapshot snapshot;
+    while ( channel.queue->pop( snapshot ) ) {
+        auto* dest = datagram.data() + headerSize + numBatched * recordSize;
+        
+        dest = writeUint32( dest, channel.instanceId );
+        dest = writeUint32( dest, channel.numDropped.load() );
+        dest = writeInt64( dest, snapshot.timelinePosition );
+        dest = writeFloat( dest, snapshot.correlationIn );
+        dest = writeFloat( dest, snapshot.correlationOut );
+        dest = writeFloat( dest, snapshot.minCorrelationIn );
+        dest = writeFloat( dest, snapshot.minCorrelationOut );
+        dest = writeFloat( dest, snapshot.rmsLeft );
+        dest = writeFloat( dest, snapshot.rmsRight );
+        
+        if ( ++numBatched == recordsPerDatagram )
+            flush();
+    }
+}
+
+void TelemetryExporter::flush() {
+    if ( numBatched == 0 )
+        return;
+    
+    // header: "SCM1" followed by the record count
+    auto* dest = datagram.data();
+    std::memcpy( dest, "SCM1", 4 );
+    writeUint32( dest + 4, static_cast< juce::uint32 >( numBatched ) );
+    
+    // a slow or absent consumer only costs the datagram, never the audio thread
+    socket.write( "127.0.0.1", port, datagram.data(), headerSize + numBatched * recordSize );
+    numBatched = 0;
+}
@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    TelemetryExporter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LockFreeFifo.h"
+#include "MeterSnapshot.h"
+
+/*
+Optional process-wide exporter that sends the meter values of every instance
+as batched binary datagrams to a UDP port on the loopback interface. It is
+enabled by setting SIMPLE_CORRELATION_METER_TELEMETRY_PORT; see README.md for
+the wire format. Obtain it through juce::SharedResourcePointer.
+*/
+class TelemetryExporter : private juce::Thread {
+public:
+    class Channel {
+    public:
+        /* audio thread: never blocks, counts the snapshot as dropped when full */
+        void push( const MeterSnapshot& snapshot ) {
+            if ( ! active.load( std::memory_order_acquire ) )
+                return;
+            
+            if ( ! queue->push( snapshot ) )
+                numDropped.fetch_add( 1, std::memory_order_relaxed );
+        }
+        
+        juce::uint32 getNumDropped() const { return numDropped.load(); }
+        
+    private:
+        friend class TelemetryExporter;
+        
+        std::atomic< bool > active{ false };
+        juce::uint32 instanceId = 0;
+        std::atomic< juce::uint32 > numDropped{ 0 };
+        
+        // tens of kilobytes, so only allocated once the exporter is enabled
+        std::unique_ptr< LockFreeFifo< MeterSnapshot, 1024 > > queue;
+    };
+    
+    TelemetryExporter();
+    ~TelemetryExporter() override;
+    
+    bool isEnabled() const { return port > 0; }
+    
+    /*
+    message thread; the channel must stay alive until removeChannel() has
+    returned, and until its audio thread has stopped pushing
+    */
+    void addChannel( Channel& channel );
+    void removeChannel( Channel& channel );
+    
+private:
+    void run() override;
+    void drain( Channel& channel );
+    void flush();
+    
+    static constexpr int headerSize = 8;
+    static constexpr int recordSize = 40;
+    static constexpr int recordsPerDatagram = 32;
+    
+    int port = 0;
+    juce::DatagramSocket socket{ false };
+    
+    juce::CriticalSection channelsLock;
+    juce::Array< Channel* > channels;
+    juce::uint32 nextInstanceId = 1;
+    
+    std::array< juce::uint8, headerSize + recordSize * recordsPerDatagram > datagram{};
+    int numBatched = 0;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TelemetryExporter)
+};
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "GuiResources.h"
 
 namespace Gui {
     class VerticalGradientMeter :
@@ -27,7 +28,70 @@ namespace Gui {
             
             auto bounds = getDisplayBounds();
             
-            // draw horizontal lines and labels for several decibel positions
+            // scale, labels and the full gradient strip come from the shared cache
+            const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+            if ( background.isNull() || backgroundScale != scale ) {
+                const String side( leftMeter ? "left" : "right" );
+                
+                background = resources->getImage( "VerticalGradientMeter " + side,
+                                                  getWidth(), getHeight(), scale,
+                                                  [ this ]( Graphics& bg ) { paintScale( bg ); } );
+                gradientStrip = resources->getImage( "VerticalGradientMeter strip " + side,
+                                                     getWidth(), getHeight(), scale,
+                                                     [ this ]( Graphics& bg ) { paintGradient( bg ); } );
+                backgroundScale = scale;
+            }
+            g.drawImage( background, getLocalBounds().toFloat() );
+            
+            // draw the current RMS level as a green to red gradient
+            const auto level = valueSupplier();
+            auto gradientBounds = getDisplayBounds();
+            const auto scaledY =
+                jmap( level, -60.f, 6.f, 0.f,
+                      static_cast< float >( bounds.getHeight() ) );
+            if ( level >= -59.9f ) {
+                // avoids drawing a green line at the bottom when no signal
+                Graphics::ScopedSaveState state( g );
+                g.reduceClipRegion( gradientBounds.removeFromBottom( scaledY ).toNearestInt() );
+                g.drawImage( gradientStrip, getLocalBounds().toFloat() );
+            }
+            
+            // draw enclosing meter box
+            g.setColour( Colours::lightgrey.withBrightness( 0.5f ) );
+            g.drawRect( bounds );
+        }
+        
+        void resized() override {
+            background = {};
+            gradientStrip = {};
+        }
+        
+        juce::Rectangle< float > getDisplayBounds() const {
+        /* determine meter display bounds within the designated meter area */
+            auto bounds = getLocalBounds().toFloat();
+            
+            int width = bounds.getWidth();
+            
+            float meterX = bounds.getX() + width * ( leftMeter? 0.8f : 0.05f );
+            float meterWidth = width * 0.15f;
+            
+            return juce::Rectangle( meterX,
+                                    bounds.getY(),
+                                    meterWidth,
+                                    bounds.getHeight() - 1 );
+        }
+        
+        void timerCallback() override {
+            repaint();
+        }
+    
+    private:
+        void paintScale( juce::Graphics& g ) const {
+        /* horizontal lines and labels for several decibel positions */
+            using namespace juce;
+            
+            auto bounds = getDisplayBounds();
+            
             std::vector< float > positions{ 0.f, -15.f, -30.f, -45.f };
             for ( auto position: positions ) {
                 g.setColour( Colours::lightgrey.withBrightness( 0.5f ) );
@@ -58,30 +122,15 @@ namespace Gui {
                                       ( float ) bounds.getX(),
                                       ( float ) bounds.getX() + bounds.getWidth() );
             }
-            
-            // draw the current RMS level as a green to red gradient
-            const auto level = valueSupplier();
-            auto gradientBounds = getDisplayBounds();
-            g.setGradientFill( gradient );
-            const auto scaledY =
-                jmap( level, -60.f, 6.f, 0.f,
-                      static_cast< float >( bounds.getHeight() ) );
-            if ( level >= -59.9f )
-                // avoids drawing a green line at the bottom when no signal
-                g.fillRect( gradientBounds.removeFromBottom( scaledY ) );
-            
-            // draw enclosing meter box
-            g.setColour( Colours::lightgrey.withBrightness( 0.5f ) );
-            g.drawRect( bounds );
         }
         
-        void resized() override {
-        /* initialize the the color gradient */
+        void paintGradient( juce::Graphics& g ) const {
+        /* the full-scale green to red gradient, clipped to the level when drawn */
             using namespace juce;
             
             const auto bounds = getDisplayBounds();
             
-            gradient = ColourGradient {
+            ColourGradient gradient {
                 Colours::green,
                 bounds.getBottomLeft(),
                 Colours::red,
@@ -90,31 +139,16 @@ namespace Gui {
             };
             
             gradient.addColour( 0.5, Colours::yellow );
-        }
-        
-        juce::Rectangle< float > getDisplayBounds() const {
-        /* determine meter display bounds within the designated meter area */
-            auto bounds = getLocalBounds().toFloat();
-            
-            int width = bounds.getWidth();
             
-            float meterX = bounds.getX() + width * ( leftMeter? 0.8f : 0.05f );
-            float meterWidth = width * 0.15f;
-            
-            return juce::Rectangle( meterX,
-                                    bounds.getY(),
-                                    meterWidth,
-                                    bounds.getHeight() - 1 );
+            g.setGradientFill( gradient );
+            g.fillRect( bounds );
         }
         
-        void timerCallback() override {
-            repaint();
-        }
-    
-    private:
         std::function< float() > valueSupplier;
         bool leftMeter;
-    
-        juce::ColourGradient gradient{};
+        
+        juce::SharedResourcePointer< GuiResources > resources;
+        juce::Image background, gradientStrip;
+        float backgroundScale = 0.f;
     };
 }